@@ -0,0 +1,300 @@
+#include "adaptive_deque.h"
+#include <counted.h>
+using container = adaptive_deque<counted, 4>;
+
+#include "tests.inl"
+
+TEST(segmented, insert_erase_middle)
+{
+    counted::no_new_instances_guard g;
+
+    segmented_deque<counted, 4> c;
+    std::vector<int> expected;
+    for (int i = 0; i != 11; ++i)
+    {
+        c.push_back(i);
+        expected.push_back(i);
+    }
+    c.push_front(-1);
+    expected.insert(expected.begin(), -1);
+    for (size_t pos : {1u, 5u, 6u, 12u, 3u})
+    {
+        c.insert(pos, 100 + int(pos));
+        expected.insert(expected.begin() + pos, 100 + int(pos));
+        EXPECT_EQ(expected, contents(c));
+    }
+    for (size_t pos : {1u, 7u, 2u, 10u})
+    {
+        c.erase(pos);
+        expected.erase(expected.begin() + pos);
+        EXPECT_EQ(expected, contents(c));
+    }
+}
+
+TEST(segmented, fault_injection_insert_middle)
+{
+    faulty_run([]
+    {
+        segmented_deque<counted, 4> c;
+        {
+            fault_injection_disable dg;
+            for (int i = 0; i != 10; ++i)
+                c.push_back(i);
+            c.push_front(-1);
+        }
+        std::vector<int> expected = iota_vector(-1, 10);
+
+        try
+        {
+            c.insert(5, 42);
+        }
+        catch (...)
+        {
+            fault_injection_disable dg;
+            EXPECT_EQ(expected, contents(c));
+            throw;
+        }
+
+        fault_injection_disable dg;
+        expected.insert(expected.begin() + 5, 42);
+        EXPECT_EQ(expected, contents(c));
+    });
+}
+
+TEST(segmented, fault_injection_erase_middle)
+{
+    faulty_run([]
+    {
+        segmented_deque<counted, 4> c;
+        {
+            fault_injection_disable dg;
+            for (int i = 0; i != 10; ++i)
+                c.push_back(i);
+            c.push_front(-1);
+        }
+        std::vector<int> expected = iota_vector(-1, 10);
+
+        try
+        {
+            c.erase(6);
+        }
+        catch (...)
+        {
+            fault_injection_disable dg;
+            EXPECT_EQ(expected, contents(c));
+            throw;
+        }
+
+        fault_injection_disable dg;
+        expected.erase(expected.begin() + 6);
+        EXPECT_EQ(expected, contents(c));
+    });
+}
+
+namespace
+{
+    // {0, ..., n - 1} in the flat representation
+    container flat_deque(int n)
+    {
+        container c;
+        for (int i = 0; i != n; ++i)
+            c.push_back(i);
+        EXPECT_FALSE(c.segmented());
+        return c;
+    }
+
+    // {0, ..., n - 1} with a 100 inserted before position 3 and removed again: two middle operations
+    container segmented_deque_of(int n)
+    {
+        container c = flat_deque(n);
+        c.insert(c.begin() + 3, 100);
+        EXPECT_FALSE(c.segmented());
+        c.erase(c.begin() + 3);
+        EXPECT_TRUE(c.segmented());
+        return c;
+    }
+
+    // how many end operations (alternating push_back and pop_front) a copy of c takes to go back to flat
+    size_t end_ops_until_flat(container const& c)
+    {
+        container copy = c;
+        size_t ops = 0;
+        while (copy.segmented() && ops < 1000)
+        {
+            if (ops % 2 == 0)
+                copy.push_back(-1);
+            else
+                copy.pop_front();
+            ++ops;
+        }
+        return ops;
+    }
+
+    // end operations first, first + 1, ..., last - 1 of the sequence end_ops_until_flat uses
+    void do_end_ops(container& c, size_t first, size_t last)
+    {
+        for (size_t i = first; i != last; ++i)
+        {
+            if (i % 2 == 0)
+                c.push_back(-1);
+            else
+                c.pop_front();
+        }
+    }
+}
+
+TEST(adaptive, flat_by_default)
+{
+    counted::no_new_instances_guard g;
+
+    container c = flat_deque(100);
+    for (int i = 0; i != 100; ++i)
+    {
+        c.push_front(i);
+        c.pop_back();
+    }
+    EXPECT_FALSE(c.segmented());
+}
+
+TEST(adaptive, two_middle_ops_segment)
+{
+    counted::no_new_instances_guard g;
+
+    container c = flat_deque(20);
+    c.insert(c.begin() + 5, 100);
+    EXPECT_FALSE(c.segmented());
+    c.insert(c.begin() + 10, 101);
+    EXPECT_TRUE(c.segmented());
+
+    std::vector<int> expected = iota_vector(0, 20);
+    expected.insert(expected.begin() + 5, 100);
+    expected.insert(expected.begin() + 10, 101);
+    EXPECT_EQ(expected, contents(c));
+}
+
+TEST(adaptive, middle_ops_far_apart_stay_flat)
+{
+    counted::no_new_instances_guard g;
+
+    container c = flat_deque(20);
+    for (int i = 0; i != 5; ++i)
+    {
+        c.insert(c.begin() + 5, 100);
+        do_end_ops(c, 0, 2 * c.size() + 4 + 2);
+        EXPECT_FALSE(c.segmented());
+    }
+}
+
+TEST(adaptive, end_ops_go_back_to_flat)
+{
+    counted::no_new_instances_guard g;
+
+    container c = segmented_deque_of(20);
+    size_t ops = end_ops_until_flat(c);
+    // about 2 * size + B end operations, size alternating between 20 and 21
+    EXPECT_LE(2 * 20 + 4 + 1u, ops);
+    EXPECT_GE(2 * 21 + 4 + 1u, ops);
+
+    do_end_ops(c, 0, ops - 1);
+    EXPECT_TRUE(c.segmented());
+    std::vector<int> expected = contents(c);
+    do_end_ops(c, ops - 1, ops);
+    EXPECT_FALSE(c.segmented());
+    if (ops % 2 == 1)
+        expected.push_back(-1);
+    else
+        expected.erase(expected.begin());
+    EXPECT_EQ(expected, contents(c));
+}
+
+TEST(adaptive, middle_op_resets_end_ops)
+{
+    counted::no_new_instances_guard g;
+
+    container c = segmented_deque_of(20);
+    size_t ops = end_ops_until_flat(c);
+    do_end_ops(c, 0, ops - 1);
+    c.insert(c.begin() + 5, 100);
+    do_end_ops(c, ops - 1, ops + 1);
+    EXPECT_TRUE(c.segmented());
+}
+
+// A conversion that fails is ignored: the operation that triggered it has already succeeded, and the deque
+// keeps its representation and contents. The fault is swallowed, so the test throws one of its own to tell
+// faulty_run that this path was taken.
+TEST(adaptive, fault_injection_convert_to_segmented)
+{
+    faulty_run([]
+    {
+        container c;
+        {
+            fault_injection_disable dg;
+            c = flat_deque(20);
+            c.insert(c.begin() + 5, 100);
+        }
+        std::vector<int> expected = iota_vector(0, 20);
+        {
+            fault_injection_disable dg;
+            expected.insert(expected.begin() + 5, 100);
+        }
+
+        try
+        {
+            c.insert(c.begin() + 10, 101);
+        }
+        catch (...)
+        {
+            // the flat ring's insert itself only gives the basic guarantee
+            fault_injection_disable dg;
+            EXPECT_FALSE(c.segmented());
+            throw;
+        }
+
+        fault_injection_disable dg;
+        expected.insert(expected.begin() + 10, 101);
+        EXPECT_EQ(expected, contents(c));
+        if (!c.segmented())
+            throw injected_fault("conversion failed");
+    });
+}
+
+TEST(adaptive, fault_injection_convert_to_flat)
+{
+    faulty_run([]
+    {
+        container c;
+        size_t ops;
+        {
+            fault_injection_disable dg;
+            c = segmented_deque_of(20);
+            ops = end_ops_until_flat(c);
+            do_end_ops(c, 0, ops - 1);
+        }
+        std::vector<int> expected = contents(c);
+
+        // the last end operation is a push_back (ops odd) or a pop_front
+        try
+        {
+            if (ops % 2 == 1)
+                c.push_back(-1);
+            else
+                c.pop_front();
+        }
+        catch (...)
+        {
+            fault_injection_disable dg;
+            EXPECT_TRUE(c.segmented());
+            EXPECT_EQ(expected, contents(c));
+            throw;
+        }
+
+        fault_injection_disable dg;
+        if (ops % 2 == 1)
+            expected.push_back(-1);
+        else
+            expected.erase(expected.begin());
+        EXPECT_EQ(expected, contents(c));
+        if (c.segmented())
+            throw injected_fault("conversion failed");
+    });
+}
@@ -0,0 +1,706 @@
+#ifndef ADAPTIVE_DEQUE_H
+#define ADAPTIVE_DEQUE_H
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fedorova_irina.h"
+
+// Deque of fixed-size blocks (my::static_circular_buffer) whose pointers live in a my::circular_buffer.
+// Every block but the first and the last is full, so element i is found in O(1). A middle insert/erase
+// shifts inside one block and then passes a single element per block towards the back: O(B + n / B).
+// That is done in place only if copying and moving T can't throw; otherwise the affected blocks are
+// rebuilt as copies and swapped in afterwards (O(n - ind) copies), so a failed insert/erase changes nothing.
+template<typename T, size_t B = 64>
+struct segmented_deque {
+    using block = my::static_circular_buffer<T, B>;
+
+    segmented_deque() noexcept : size_(0) {}
+
+    segmented_deque(segmented_deque const &other) : size_(0) {
+        try {
+            for (size_t i = 0; i < other.blocks.size(); ++i) {
+                append_block(std::make_unique<block>(*other.blocks[i]));
+            }
+        } catch (...) {
+            free_blocks();
+            throw;
+        }
+        size_ = other.size_;
+    }
+
+    segmented_deque &operator=(segmented_deque const &other) {
+        segmented_deque tmp(other);
+        swap(tmp);
+        return *this;
+    }
+
+    ~segmented_deque() {
+        free_blocks();
+    }
+
+    void swap(segmented_deque &other) noexcept {
+        my::swap(blocks, other.blocks);
+        std::swap(size_, other.size_);
+    }
+
+    size_t size() const noexcept {
+        return size_;
+    }
+
+    bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    void clear() noexcept {
+        free_blocks();
+        size_ = 0;
+    }
+
+    T &operator[](size_t ind) {
+        block *first = blocks[0];
+        if (ind < first->size()) {
+            return (*first)[ind];
+        }
+        ind -= first->size();
+        return (*blocks[1 + ind / B])[ind % B];
+    }
+
+    T const &operator[](size_t ind) const {
+        return const_cast<segmented_deque &>(*this)[ind];
+    }
+
+    void push_back(T const &val) {
+        if (blocks.empty() || blocks.back()->full()) {
+            std::unique_ptr<block> b = std::make_unique<block>();
+            b->push_back(val);
+            append_block(std::move(b));
+        } else {
+            blocks.back()->push_back(val);
+        }
+        ++size_;
+    }
+
+    void push_front(T const &val) {
+        if (blocks.empty() || blocks.front()->full()) {
+            std::unique_ptr<block> b = std::make_unique<block>();
+            b->push_front(val);
+            blocks.push_front(b.get());
+            b.release();
+        } else {
+            blocks.front()->push_front(val);
+        }
+        ++size_;
+    }
+
+    void pop_back() noexcept {
+        blocks.back()->pop_back();
+        if (blocks.back()->empty()) {
+            delete blocks.back();
+            blocks.pop_back();
+        }
+        --size_;
+    }
+
+    void pop_front() noexcept {
+        blocks.front()->pop_front();
+        if (blocks.front()->empty()) {
+            delete blocks.front();
+            blocks.pop_front();
+        }
+        --size_;
+    }
+
+    // val goes before element ind
+    void insert(size_t ind, T const &val) {
+        if (ind == size_) {
+            push_back(val);
+        } else if (ind == 0) {
+            push_front(val);
+        } else {
+            insert_middle(ind, val);
+        }
+    }
+
+    void erase(size_t ind) {
+        if (ind + 1 == size_) {
+            pop_back();
+        } else if (ind == 0) {
+            pop_front();
+        } else {
+            erase_middle(ind);
+        }
+    }
+
+private:
+    my::circular_buffer<block *> blocks;
+    size_t size_;
+
+    void append_block(std::unique_ptr<block> b) {
+        blocks.push_back(b.get());
+        b.release();
+    }
+
+    void free_blocks() noexcept {
+        while (!blocks.empty()) {
+            delete blocks.back();
+            blocks.pop_back();
+        }
+    }
+
+    void locate(size_t ind, size_t &block_ind, size_t &offset) const {
+        size_t first = blocks[0]->size();
+        if (ind < first) {
+            block_ind = 0;
+            offset = ind;
+        } else {
+            block_ind = 1 + (ind - first) / B;
+            offset = (ind - first) % B;
+        }
+    }
+
+    static void insert_into(block &b, size_t offset, T const &val) {
+        b.push_back(val);
+        for (size_t i = b.size() - 1; i > offset; --i) {
+            std::swap(b[i], b[i - 1]);
+        }
+    }
+
+    void insert_middle(size_t ind, T const &value) {
+        size_t block_ind, offset;
+        locate(ind, block_ind, offset);
+        if (!nothrow_shift) {
+            insert_copying(block_ind, offset, value);
+            ++size_;
+            return;
+        }
+
+        T val(value);
+        block *b = blocks[block_ind];
+        if (b->full() && blocks.back()->full()) {
+            // the carried element will need a new block, get it before anything moves
+            append_block(std::make_unique<block>());
+        }
+        if (!b->full()) {
+            insert_into(*b, offset, val);
+            ++size_;
+            return;
+        }
+
+        // the block overflows by one: its last element is carried into the next one, and so on
+        T carry(std::move_if_noexcept(b->back()));
+        b->pop_back();
+        insert_into(*b, offset, val);
+        ++size_;
+        for (size_t i = block_ind + 1; i != blocks.size(); ++i) {
+            block *next = blocks[i];
+            if (!next->full()) {
+                next->push_front(carry);
+                return;
+            }
+            T next_carry(std::move_if_noexcept(next->back()));
+            next->pop_back();
+            next->push_front(carry);
+            carry = std::move(next_carry);
+        }
+    }
+
+    void erase_middle(size_t ind) {
+        size_t block_ind, offset;
+        locate(ind, block_ind, offset);
+        if (!nothrow_shift) {
+            erase_copying(block_ind, offset);
+            --size_;
+            return;
+        }
+
+        block *b = blocks[block_ind];
+        --size_;
+        if (block_ind == 0) {
+            // the first block may be short, nothing else moves
+            for (size_t i = offset; i > 0; --i) {
+                std::swap((*b)[i], (*b)[i - 1]);
+            }
+            b->pop_front();
+            if (b->empty()) {
+                delete b;
+                blocks.pop_front();
+            }
+            return;
+        }
+
+        for (size_t i = offset; i + 1 < b->size(); ++i) {
+            std::swap((*b)[i], (*b)[i + 1]);
+        }
+        b->pop_back();
+        // refill from the following blocks, one element each
+        for (size_t i = block_ind + 1; i != blocks.size(); ++i) {
+            blocks[i - 1]->push_back(blocks[i]->front());
+            blocks[i]->pop_front();
+        }
+        if (blocks.back()->empty()) {
+            delete blocks.back();
+            blocks.pop_back();
+        }
+    }
+
+    // element j counted from the start of blocks[block_ind], every block before the last one involved is full
+    T const &element_from(size_t block_ind, size_t j) const {
+        return (*blocks[block_ind + j / B])[j % B];
+    }
+
+    // count elements element(0), element(1), ... copied into fresh blocks of B
+    template<typename Element>
+    static std::vector<std::unique_ptr<block>> copy_blocks(size_t count, Element element) {
+        std::vector<std::unique_ptr<block>> fresh;
+        for (size_t j = 0; j < count; ++j) {
+            if (j % B == 0) {
+                fresh.push_back(std::make_unique<block>());
+            }
+            fresh.back()->push_back(element(j));
+        }
+        return fresh;
+    }
+
+    void replace_blocks(size_t first, std::vector<std::unique_ptr<block>> &fresh) noexcept {
+        for (size_t i = 0; i < fresh.size(); ++i) {
+            delete blocks[first + i];
+            blocks[first + i] = fresh[i].release();
+        }
+    }
+
+    // rebuilds the blocks from block_ind up to the first one with room (or a new one)
+    void insert_copying(size_t block_ind, size_t offset, T const &val) {
+        size_t last = block_ind;
+        size_t count = 1;
+        while (last != blocks.size() && blocks[last]->full()) {
+            count += B;
+            ++last;
+        }
+        bool grows = last == blocks.size();
+        if (!grows) {
+            count += blocks[last]->size();
+        }
+        std::vector<std::unique_ptr<block>> fresh = copy_blocks(count, [&](size_t j) -> T const & {
+            if (j == offset) {
+                return val;
+            }
+            return element_from(block_ind, j < offset ? j : j - 1);
+        });
+        if (grows) {
+            blocks.push_back(nullptr);
+        }
+        replace_blocks(block_ind, fresh);
+    }
+
+    // rebuilds the first block, or every block from block_ind on
+    void erase_copying(size_t block_ind, size_t offset) {
+        size_t end = block_ind == 0 ? 1 : blocks.size();
+        size_t count = 0;
+        for (size_t i = block_ind; i != end; ++i) {
+            count += blocks[i]->size();
+        }
+        --count;
+        std::vector<std::unique_ptr<block>> fresh = copy_blocks(count, [&](size_t j) -> T const & {
+            return element_from(block_ind, j < offset ? j : j + 1);
+        });
+        replace_blocks(block_ind, fresh);
+        if (block_ind + fresh.size() != end) {
+            // the range lost its last block
+            delete blocks[end - 1];
+            if (block_ind == 0) {
+                blocks.pop_front();
+            } else {
+                blocks.pop_back();
+            }
+        }
+    }
+
+    static constexpr bool nothrow_shift = std::is_nothrow_copy_constructible<T>::value
+                                          && std::is_nothrow_copy_assignable<T>::value
+                                          && std::is_nothrow_move_constructible<T>::value
+                                          && std::is_nothrow_move_assignable<T>::value;
+};
+
+// Deque that is a flat my::circular_buffer while it's used as a queue and turns into a segmented_deque
+// after repeated middle inserts/erases or once it gets very large. After more end-only operations than
+// twice its size (which pays for the copy) it goes back to the flat ring. A failed conversion is ignored,
+// the operation that triggered it has already succeeded.
+template<typename T, size_t B = 64>
+struct adaptive_deque {
+    static constexpr size_t middle_ops_to_segment = 2;
+    static constexpr size_t large_size = size_t(1) << 20;
+
+private:
+    struct representation;
+
+public:
+    template<bool is_const>
+    struct iterator_buf {
+        friend adaptive_deque;
+
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = ptrdiff_t;
+        using pointer = std::conditional_t<is_const, value_type const *, value_type *>;
+        using reference = std::conditional_t<is_const, value_type const &, value_type &>;
+
+    private:
+        using owner = std::conditional_t<is_const, representation const, representation>;
+
+        owner *deq;
+        size_t ind;
+
+        iterator_buf(owner *deq, size_t ind) noexcept : deq(deq), ind(ind) {}
+
+    public:
+        iterator_buf() noexcept : deq(nullptr), ind(0) {}
+
+        template<bool other_const, typename = std::enable_if_t<is_const && !other_const>>
+        iterator_buf(iterator_buf<other_const> const &other) noexcept : deq(other.deq), ind(other.ind) {}
+
+        reference operator*() const {
+            return (*deq)[ind];
+        }
+
+        pointer operator->() const {
+            return &(*deq)[ind];
+        }
+
+        reference operator[](difference_type shift) const {
+            return (*deq)[ind + shift];
+        }
+
+        iterator_buf &operator++() noexcept {
+            ++ind;
+            return *this;
+        }
+
+        iterator_buf operator++(int) noexcept {
+            iterator_buf ret = *this;
+            ++ind;
+            return ret;
+        }
+
+        iterator_buf &operator--() noexcept {
+            --ind;
+            return *this;
+        }
+
+        iterator_buf operator--(int) noexcept {
+            iterator_buf ret = *this;
+            --ind;
+            return ret;
+        }
+
+        iterator_buf &operator+=(difference_type shift) noexcept {
+            ind += shift;
+            return *this;
+        }
+
+        iterator_buf &operator-=(difference_type shift) noexcept {
+            ind -= shift;
+            return *this;
+        }
+
+        iterator_buf operator+(difference_type shift) const noexcept {
+            return iterator_buf(deq, ind + shift);
+        }
+
+        iterator_buf operator-(difference_type shift) const noexcept {
+            return iterator_buf(deq, ind - shift);
+        }
+
+        difference_type operator-(iterator_buf const &it2) const noexcept {
+            return (difference_type) ind - (difference_type) it2.ind;
+        }
+
+        template<bool other_const>
+        bool operator==(iterator_buf<other_const> const &it2) const noexcept {
+            return deq == it2.deq && ind == it2.ind;
+        }
+
+        template<bool other_const>
+        bool operator!=(iterator_buf<other_const> const &it2) const noexcept {
+            return !(*this == it2);
+        }
+
+        bool operator<(iterator_buf const &it2) const noexcept {
+            return ind < it2.ind;
+        }
+
+        bool operator>(iterator_buf const &it2) const noexcept {
+            return it2 < *this;
+        }
+
+        bool operator<=(iterator_buf const &it2) const noexcept {
+            return !(it2 < *this);
+        }
+
+        bool operator>=(iterator_buf const &it2) const noexcept {
+            return !(*this < it2);
+        }
+
+        template<bool>
+        friend struct iterator_buf;
+    };
+
+    typedef iterator_buf<false> iterator;
+    typedef iterator_buf<true> const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    adaptive_deque() noexcept = default;
+
+    adaptive_deque(adaptive_deque const &other)
+            : rep(other.rep ? std::make_unique<representation>(*other.rep) : nullptr) {}
+
+    adaptive_deque &operator=(adaptive_deque const &other) {
+        adaptive_deque tmp(other);
+        swap(tmp);
+        return *this;
+    }
+
+    void swap(adaptive_deque &other) noexcept {
+        std::swap(rep, other.rep);
+    }
+
+    bool segmented() const noexcept {
+        return rep && rep->is_segmented;
+    }
+
+    size_t size() const noexcept {
+        return rep ? rep->size() : 0;
+    }
+
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    void clear() noexcept {
+        if (rep) {
+            rep->flat.clear();
+            rep->segments.clear();
+        }
+    }
+
+    T &operator[](size_t ind) {
+        return (*rep)[ind];
+    }
+
+    T const &operator[](size_t ind) const {
+        return (*rep)[ind];
+    }
+
+    T &front() {
+        return (*this)[0];
+    }
+
+    T const &front() const {
+        return (*this)[0];
+    }
+
+    T &back() {
+        return (*this)[size() - 1];
+    }
+
+    T const &back() const {
+        return (*this)[size() - 1];
+    }
+
+    void push_back(T const &val) {
+        representation &r = get_rep();
+        if (r.is_segmented) {
+            r.segments.push_back(val);
+        } else {
+            r.flat.push_back(val);
+        }
+        r.note_end_op();
+    }
+
+    void push_front(T const &val) {
+        representation &r = get_rep();
+        if (r.is_segmented) {
+            r.segments.push_front(val);
+        } else {
+            r.flat.push_front(val);
+        }
+        r.note_end_op();
+    }
+
+    void pop_back() {
+        if (rep->is_segmented) {
+            rep->segments.pop_back();
+        } else {
+            rep->flat.pop_back();
+        }
+        rep->note_end_op();
+    }
+
+    void pop_front() {
+        if (rep->is_segmented) {
+            rep->segments.pop_front();
+        } else {
+            rep->flat.pop_front();
+        }
+        rep->note_end_op();
+    }
+
+    iterator insert(const_iterator pos, T const &val) {
+        size_t ind = pos.ind;
+        if (ind == size()) {
+            push_back(val);
+        } else if (ind == 0) {
+            push_front(val);
+        } else {
+            if (rep->is_segmented) {
+                rep->segments.insert(ind, val);
+            } else {
+                rep->flat.insert(rep->flat.begin() + (ptrdiff_t) ind, val);
+            }
+            rep->note_middle_op();
+        }
+        return iterator(rep.get(), ind);
+    }
+
+    iterator erase(const_iterator pos) {
+        size_t ind = pos.ind;
+        if (ind + 1 == size()) {
+            pop_back();
+        } else if (ind == 0) {
+            pop_front();
+        } else {
+            if (rep->is_segmented) {
+                rep->segments.erase(ind);
+            } else {
+                rep->flat.erase(rep->flat.begin() + (ptrdiff_t) ind);
+            }
+            rep->note_middle_op();
+        }
+        return iterator(rep.get(), ind);
+    }
+
+    iterator begin() noexcept {
+        return iterator(rep.get(), 0);
+    }
+
+    iterator end() noexcept {
+        return iterator(rep.get(), size());
+    }
+
+    const_iterator begin() const noexcept {
+        return const_iterator(rep.get(), 0);
+    }
+
+    const_iterator end() const noexcept {
+        return const_iterator(rep.get(), size());
+    }
+
+    reverse_iterator rbegin() noexcept {
+        return reverse_iterator(end());
+    }
+
+    reverse_iterator rend() noexcept {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rbegin() const noexcept {
+        return const_reverse_iterator(end());
+    }
+
+    const_reverse_iterator rend() const noexcept {
+        return const_reverse_iterator(begin());
+    }
+
+private:
+    // Kept on the heap so that iterators, which point here, follow the elements through swap.
+    struct representation {
+        my::circular_buffer<T> flat;
+        segmented_deque<T, B> segments;
+        bool is_segmented = false;
+        size_t middle_ops = 0;
+        size_t end_ops = 0;
+
+        size_t size() const noexcept {
+            return is_segmented ? segments.size() : flat.size();
+        }
+
+        T &operator[](size_t ind) {
+            return is_segmented ? segments[ind] : flat[ind];
+        }
+
+        T const &operator[](size_t ind) const {
+            return is_segmented ? segments[ind] : flat[ind];
+        }
+
+        void note_end_op() {
+            ++end_ops;
+            if (is_segmented) {
+                if (end_ops > 2 * size() + B && size() < large_size / 2) {
+                    convert();
+                }
+            } else if (size() > large_size) {
+                convert();
+            } else if (end_ops > 2 * size() + B) {
+                // middle operations that far apart don't add up
+                middle_ops = 0;
+                end_ops = 0;
+            }
+        }
+
+        void note_middle_op() {
+            end_ops = 0;
+            if (!is_segmented && ++middle_ops >= middle_ops_to_segment) {
+                convert();
+            }
+        }
+
+        // moves the elements to the other representation
+        void convert() {
+            try {
+                if (is_segmented) {
+                    my::circular_buffer<T> tmp;
+                    for (size_t i = 0; i < segments.size(); ++i) {
+                        tmp.push_back(segments[i]);
+                    }
+                    my::swap(flat, tmp);
+                    segments.clear();
+                } else {
+                    segmented_deque<T, B> tmp;
+                    for (size_t i = 0; i < flat.size(); ++i) {
+                        tmp.push_back(flat[i]);
+                    }
+                    segments.swap(tmp);
+                    my::circular_buffer<T> empty;
+                    my::swap(flat, empty);
+                }
+            } catch (...) {
+                return;
+            }
+            is_segmented = !is_segmented;
+            middle_ops = 0;
+            end_ops = 0;
+        }
+    };
+
+    // allocated by the first push, so the default constructor doesn't throw
+    std::unique_ptr<representation> rep;
+
+    representation &get_rep() {
+        if (!rep) {
+            rep = std::make_unique<representation>();
+        }
+        return *rep;
+    }
+};
+
+template<typename T, size_t B>
+void swap(adaptive_deque<T, B> &a, adaptive_deque<T, B> &b) noexcept {
+    a.swap(b);
+}
+
+#endif //ADAPTIVE_DEQUE_H
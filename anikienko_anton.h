@@ -4,8 +4,15 @@
 #include<vector>
 #include<iostream>
 #include<cassert>
+#include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <cstdlib>
 #include <exception>
+#include <new>
+#include <type_traits>
+
+#include "ring_spans.h"
 
 template<typename T> class RingBuffer {
 private:
@@ -17,6 +24,11 @@ private:
     T* buffer;
 
     void increst_capacity() {
+        if (std::is_trivially_copyable<T>::value) {
+            relocate_capacity();
+            return;
+        }
+
         uint64_t new_max_size = max_size << 1;
         T* new_buffer = (T*)malloc(sizeof(T)*new_max_size);
         uint64_t cur = 0;
@@ -32,11 +44,36 @@ private:
             begin_id += max_size;
         }
 
-        delete buffer;
+        free(buffer);
         buffer = new_buffer;
         max_size = new_max_size;
     }
 
+    // elements can be moved with plain memory copies, so realloc may grow the block in place
+    // (or remap its pages) and only the shorter part of a wrapped ring has to be moved
+    void relocate_capacity() {
+        uint64_t new_max_size = max_size << 1;
+        T* new_buffer = (T*)realloc(buffer, sizeof(T)*new_max_size);
+        if (new_buffer == nullptr) throw std::bad_alloc();
+        buffer = new_buffer;
+
+        if (begin_id > end_id) {
+            uint64_t left_size = end_id + 1;
+            uint64_t right_size = max_size - begin_id;
+
+            if (left_size <= right_size) {
+                memcpy(&buffer[max_size], buffer, left_size * sizeof(T));
+                end_id += max_size;
+            }
+            else {
+                memcpy(&buffer[new_max_size - right_size], &buffer[begin_id], right_size * sizeof(T));
+                begin_id += max_size;
+            }
+        }
+
+        max_size = new_max_size;
+    }
+
     template <typename U>
     struct Iterator {
     private:
@@ -137,6 +174,9 @@ public:
     size_t size() const { return cur_size; }
     size_t capacity() const { return max_size; }
 
+    ring_spans<T> as_spans() { return make_ring_spans(buffer, max_size, begin_id, cur_size); }
+    ring_spans<const T> as_spans() const { return make_ring_spans<const T>(buffer, max_size, begin_id, cur_size); }
+
     using iterator = Iterator<T>;
     using const_iterator = Iterator<const T>;
     using reverse_iterator = std::reverse_iterator<iterator>;
@@ -176,6 +216,7 @@ public:
     }
     ~RingBuffer() {
         clear();
+        free(buffer);
     }
 
     void push_back(const T &element) {
@@ -283,6 +324,131 @@ template<typename T> void swap(RingBuffer<T>&left, RingBuffer<T>&right) {
     left.swap(right);
 }
 
+// Lock-free queue for exactly one producer thread and one consumer thread.
+// Capacity is fixed (rounded up to a power of two); ids grow monotonically and are masked into the buffer.
+// Each side owns one index, publishes it with release and caches the other side's index,
+// so the shared cache line is only touched when the cached view says the queue is full/empty.
+template<typename T> class SpscRingBuffer {
+private:
+    static const size_t CACHE_LINE = 64;
+
+    uint64_t max_size;
+    uint64_t mask;
+    T* buffer;
+
+    alignas(CACHE_LINE) std::atomic<uint64_t> begin_id; // written by consumer
+    uint64_t cached_end_id;                              // consumer's view of end_id
+
+    alignas(CACHE_LINE) std::atomic<uint64_t> end_id;   // written by producer
+    uint64_t cached_begin_id;                            // producer's view of begin_id
+
+    uint64_t free_slots(uint64_t end) {
+        uint64_t result = max_size - (end - cached_begin_id);
+        if (result == 0) {
+            cached_begin_id = begin_id.load(std::memory_order_acquire);
+            result = max_size - (end - cached_begin_id);
+        }
+        return result;
+    }
+    uint64_t used_slots(uint64_t begin) {
+        uint64_t result = cached_end_id - begin;
+        if (result == 0) {
+            cached_end_id = end_id.load(std::memory_order_acquire);
+            result = cached_end_id - begin;
+        }
+        return result;
+    }
+
+public:
+    explicit SpscRingBuffer(const uint64_t min_size = 1024) : max_size(1), begin_id(0), cached_end_id(0), end_id(0), cached_begin_id(0) {
+        while (max_size < min_size) max_size <<= 1;
+        mask = max_size - 1;
+        buffer = (T*)malloc(sizeof(T)*max_size);
+        if (buffer == nullptr) throw std::bad_alloc();
+    }
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+    ~SpscRingBuffer() {
+        uint64_t end = end_id.load(std::memory_order_acquire);
+        for (uint64_t id = begin_id.load(std::memory_order_relaxed); id != end; id++)
+            buffer[id & mask].~T();
+        free(buffer);
+    }
+
+    size_t capacity() const { return max_size; }
+    // exact only when called from the producer or the consumer while the other side is idle
+    size_t size() const { return end_id.load(std::memory_order_acquire) - begin_id.load(std::memory_order_acquire); }
+    bool empty() const { return size() == 0; }
+
+    // producer side
+    bool try_push(const T &element) {
+        uint64_t end = end_id.load(std::memory_order_relaxed);
+        if (free_slots(end) == 0) return false;
+        new (&buffer[end & mask]) T(element);
+        end_id.store(end + 1, std::memory_order_release);
+        return true;
+    }
+    // pushes up to n elements from first, publishes them with a single store, returns how many were pushed
+    template<typename InputIt> size_t try_push(InputIt first, size_t n) {
+        uint64_t end = end_id.load(std::memory_order_relaxed);
+        uint64_t count = max_size - (end - cached_begin_id);
+        if (count < n) {
+            cached_begin_id = begin_id.load(std::memory_order_acquire);
+            count = max_size - (end - cached_begin_id);
+        }
+        count = std::min<uint64_t>(count, n);
+
+        uint64_t cur = 0;
+        try {
+            for (; cur < count; cur++, ++first)
+                new (&buffer[(end + cur) & mask]) T(*first);
+        }
+        catch (...) {
+            while (cur != 0) buffer[(end + --cur) & mask].~T();
+            throw;
+        }
+        end_id.store(end + count, std::memory_order_release);
+        return count;
+    }
+
+    // consumer side
+    bool try_pop(T &element) {
+        uint64_t begin = begin_id.load(std::memory_order_relaxed);
+        if (used_slots(begin) == 0) return false;
+        T& slot = buffer[begin & mask];
+        element = std::move(slot);
+        slot.~T();
+        begin_id.store(begin + 1, std::memory_order_release);
+        return true;
+    }
+    // pops up to n elements into out, releases the slots with a single store, returns how many were popped;
+    // if writing to out throws, the elements already popped stay popped and their slots are released
+    template<typename OutputIt> size_t try_pop(OutputIt out, size_t n) {
+        uint64_t begin = begin_id.load(std::memory_order_relaxed);
+        uint64_t count = cached_end_id - begin;
+        if (count < n) {
+            cached_end_id = end_id.load(std::memory_order_acquire);
+            count = cached_end_id - begin;
+        }
+        count = std::min<uint64_t>(count, n);
+
+        uint64_t cur = 0;
+        try {
+            for (; cur < count; cur++, ++out) {
+                T& slot = buffer[(begin + cur) & mask];
+                *out = std::move(slot);
+                slot.~T();
+            }
+        }
+        catch (...) {
+            begin_id.store(begin + cur, std::memory_order_release);
+            throw;
+        }
+        begin_id.store(begin + count, std::memory_order_release);
+        return count;
+    }
+};
+
 class Tester {
 public:
     RingBuffer<int> *buffer;
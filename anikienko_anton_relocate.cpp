@@ -0,0 +1,96 @@
+#include "anikienko_anton.h"
+#include <gtest/gtest.h>
+
+namespace
+{
+    std::vector<int> contents(RingBuffer<int>& c)
+    {
+        std::vector<int> res;
+        for (size_t i = 0; i != c.size(); ++i)
+            res.push_back(c[i]);
+        return res;
+    }
+
+    std::vector<int> iota_vector(int first, int last)
+    {
+        std::vector<int> res;
+        for (int i = first; i != last; ++i)
+            res.push_back(i);
+        return res;
+    }
+
+    // fills a ring of capacity front_n + back_n: front_n elements go below slot 0 (to the end of the buffer)
+    // and back_n from slot 0 up, so the full ring wraps unless front_n is 0; contents are 0, 1, ...
+    void fill(RingBuffer<int>& c, int front_n, int back_n)
+    {
+        for (int i = front_n; i != 0; --i)
+            c.push_front(i - 1);
+        for (int i = 0; i != back_n; ++i)
+            c.push_back(front_n + i);
+        ASSERT_EQ(size_t(front_n + back_n), c.size());
+        ASSERT_EQ(size_t(front_n + back_n), c.capacity());
+    }
+}
+
+TEST(relocate, not_wrapped)
+{
+    RingBuffer<int> c(4);
+    fill(c, 0, 4);
+    EXPECT_EQ(c.front() + 3, c.back());
+    c.push_back(4);
+    EXPECT_EQ(8u, c.capacity());
+    EXPECT_EQ(iota_vector(0, 5), contents(c));
+    c.push_front(-1);
+    EXPECT_EQ(iota_vector(-1, 5), contents(c));
+}
+
+TEST(relocate, wrapped_left_part_shorter)
+{
+    RingBuffer<int> c(8);
+    fill(c, 5, 3);
+    EXPECT_GT(c.front(), c.back());
+    c.push_back(8);
+    EXPECT_EQ(16u, c.capacity());
+    EXPECT_EQ(iota_vector(0, 9), contents(c));
+    EXPECT_LT(c.front(), c.back());
+    c.push_front(-1);
+    EXPECT_EQ(iota_vector(-1, 9), contents(c));
+}
+
+TEST(relocate, wrapped_right_part_shorter)
+{
+    RingBuffer<int> c(8);
+    fill(c, 3, 5);
+    EXPECT_GT(c.front(), c.back());
+    c.push_front(-1);
+    EXPECT_EQ(16u, c.capacity());
+    EXPECT_EQ(iota_vector(-1, 8), contents(c));
+    EXPECT_GT(c.front(), c.back());
+    c.push_back(8);
+    EXPECT_EQ(iota_vector(-1, 9), contents(c));
+}
+
+TEST(relocate, repeated_growth)
+{
+    RingBuffer<int> c(1);
+    std::vector<int> expected;
+    for (int i = 0; i != 1000; ++i)
+    {
+        if (i % 3 == 0)
+        {
+            c.push_front(-i);
+            expected.insert(expected.begin(), -i);
+        }
+        else
+        {
+            c.push_back(i);
+            expected.push_back(i);
+        }
+        if (i % 7 == 0)
+        {
+            c.pop_front();
+            expected.erase(expected.begin());
+        }
+    }
+    EXPECT_EQ(expected, contents(c));
+}
@@ -0,0 +1,130 @@
+#include "anikienko_anton.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    size_t const OPS = 1 << 22;
+    size_t const QUEUE_SIZE = 1024;
+
+    // the baseline: std::deque behind a mutex, batches are moved under a single lock
+    struct locked_queue
+    {
+        explicit locked_queue(size_t max_size)
+            : max_size(max_size)
+        {}
+
+        bool try_push(size_t const& val)
+        {
+            return try_push(&val, 1) == 1;
+        }
+
+        template <typename InputIt>
+        size_t try_push(InputIt first, size_t n)
+        {
+            std::lock_guard<std::mutex> lg(m);
+            n = std::min(n, max_size - items.size());
+            for (size_t i = 0; i != n; ++i, ++first)
+                items.push_back(*first);
+            return n;
+        }
+
+        bool try_pop(size_t& out)
+        {
+            return try_pop(&out, 1) == 1;
+        }
+
+        template <typename OutputIt>
+        size_t try_pop(OutputIt out, size_t n)
+        {
+            std::lock_guard<std::mutex> lg(m);
+            n = std::min(n, items.size());
+            for (size_t i = 0; i != n; ++i, ++out)
+            {
+                *out = items.front();
+                items.pop_front();
+            }
+            return n;
+        }
+
+    private:
+        std::mutex m;
+        size_t max_size;
+        std::deque<size_t> items;
+    };
+
+    bool ordered = true;
+
+    // one producer passes 0, 1, ..., OPS - 1 to one consumer, batch values at a time
+    // (one by one through try_push/try_pop(T&) when batch is 1); the consumer checks the order
+    template <typename Queue>
+    double run(size_t batch)
+    {
+        Queue q(QUEUE_SIZE);
+
+        auto start = std::chrono::steady_clock::now();
+        std::thread producer([&q, batch]
+        {
+            std::vector<size_t> vals(batch);
+            for (size_t i = 0; i < OPS;)
+            {
+                size_t n = std::min(batch, OPS - i);
+                size_t pushed;
+                if (batch == 1)
+                {
+                    pushed = q.try_push(i) ? 1 : 0;
+                }
+                else
+                {
+                    for (size_t k = 0; k != n; ++k)
+                        vals[k] = i + k;
+                    pushed = q.try_push(vals.begin(), n);
+                }
+                if (pushed == 0)
+                    std::this_thread::yield();
+                i += pushed;
+            }
+        });
+
+        std::vector<size_t> vals(batch);
+        size_t expected = 0;
+        while (expected != OPS)
+        {
+            size_t popped;
+            if (batch == 1)
+                popped = q.try_pop(vals[0]) ? 1 : 0;
+            else
+                popped = q.try_pop(vals.begin(), batch);
+            if (popped == 0)
+                std::this_thread::yield();
+            for (size_t k = 0; k != popped; ++k, ++expected)
+                if (vals[k] != expected)
+                    ordered = false;
+        }
+        producer.join();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        // nothing may be left over
+        if (q.try_pop(vals[0]))
+            ordered = false;
+        return OPS / elapsed.count() / 1e6;
+    }
+}
+
+int main()
+{
+    std::printf("%8s %16s %16s\n", "batch", "spsc Mops", "mutex Mops");
+    for (size_t batch = 1; batch <= 256; batch *= 4)
+        std::printf("%8zu %16.2f %16.2f\n", batch, run<SpscRingBuffer<size_t>>(batch), run<locked_queue>(batch));
+
+    if (!ordered)
+    {
+        std::fprintf(stderr, "values arrived out of order\n");
+        return 1;
+    }
+}
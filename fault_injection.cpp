@@ -1,10 +1,25 @@
 #include "fault_injection.h"
+#include <atomic>
 #include <cassert>
+#include <cstdlib>
 #include <iostream>
+#include <mutex>
 #include <vector>
 
 #include <sys/mman.h>
 
+#if defined(__SANITIZE_ADDRESS__)
+#define ARENA_ASAN 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define ARENA_ASAN 1
+#endif
+#endif
+
+#ifdef ARENA_ASAN
+#include <sanitizer/asan_interface.h>
+#endif
+
 namespace
 {
     template <typename T>
@@ -39,6 +54,170 @@ namespace
         bool fault_registred = false;
     };
     
+    // Address space reserved for one allocation_arena; pages are only backed once touched.
+    // Regions are never unmapped, so operator delete can always tell arena memory apart.
+    struct arena_region
+    {
+        char* base = nullptr;
+        size_t used = 0;
+        size_t allocations = 0;
+        std::atomic<size_t> live{0};
+        std::atomic<bool> busy{false};
+    };
+
+    size_t const ARENA_RESERVE = size_t(1) << 32;
+    size_t const ARENA_RETAIN = size_t(16) << 20;
+    size_t const ARENA_ALIGNMENT = 16;
+    size_t const MAX_ARENA_REGIONS = 64;
+#ifdef ARENA_ASAN
+    // Under AddressSanitizer every arena block is surrounded by poisoned red zones and poisoned again
+    // when deleted, so overflows and uses after delete are still reported. The front red zone holds
+    // the requested size and whether the block was already deleted.
+    size_t const ARENA_REDZONE = 16;
+
+    struct arena_block_header
+    {
+        size_t count;
+        size_t deleted;
+    };
+
+    static_assert(sizeof(arena_block_header) <= ARENA_REDZONE, "the header lives in the red zone");
+#else
+    size_t const ARENA_REDZONE = 0;
+#endif
+
+    arena_region arena_regions[MAX_ARENA_REGIONS];
+    std::atomic<size_t> arena_region_count(0);
+    std::mutex arena_regions_mutex;
+
+    thread_local arena_region* current_arena = nullptr;
+
+    // a free region, or nullptr if all of them are taken or hold leaked allocations
+    arena_region* acquire_arena_region()
+    {
+        std::lock_guard<std::mutex> lg(arena_regions_mutex);
+        size_t count = arena_region_count.load(std::memory_order_relaxed);
+        for (size_t i = 0; i != count; ++i)
+        {
+            arena_region& r = arena_regions[i];
+            if (!r.busy.load(std::memory_order_relaxed) && r.live.load(std::memory_order_acquire) == 0)
+            {
+                r.busy.store(true, std::memory_order_relaxed);
+                return &r;
+            }
+        }
+        if (count == MAX_ARENA_REGIONS)
+            return nullptr;
+        void* ptr = mmap(nullptr, ARENA_RESERVE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (ptr == MAP_FAILED)
+            return nullptr;
+        arena_region& r = arena_regions[count];
+        r.base = static_cast<char*>(ptr);
+        r.busy.store(true, std::memory_order_relaxed);
+        arena_region_count.store(count + 1, std::memory_order_release);
+        return &r;
+    }
+
+    void release_arena_region(arena_region* r)
+    {
+        std::lock_guard<std::mutex> lg(arena_regions_mutex);
+        if (r->live.load(std::memory_order_acquire) == 0)
+        {
+#ifdef ARENA_ASAN
+            ASAN_POISON_MEMORY_REGION(r->base, r->used);
+#endif
+            if (r->used > ARENA_RETAIN)
+                madvise(r->base + ARENA_RETAIN, r->used - ARENA_RETAIN, MADV_DONTNEED);
+            r->used = 0;
+            r->allocations = 0;
+            r->busy.store(false, std::memory_order_relaxed);
+        }
+        // otherwise the region stays busy for good, keeping the leaked objects valid
+    }
+
+    void* arena_allocate(size_t count)
+    {
+        arena_region* r = current_arena;
+        size_t size = (count + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+        if (size == 0)
+            size = ARENA_ALIGNMENT;
+        size_t total = ARENA_REDZONE + size + ARENA_REDZONE;
+        if (total > ARENA_RESERVE - r->used)
+            return nullptr;
+        char* block = r->base + r->used;
+        char* ptr = block + ARENA_REDZONE;
+        r->used += total;
+        ++r->allocations;
+        r->live.fetch_add(1, std::memory_order_relaxed);
+#ifdef ARENA_ASAN
+        ASAN_UNPOISON_MEMORY_REGION(block, sizeof(arena_block_header));
+        *reinterpret_cast<arena_block_header*>(block) = arena_block_header{count, 0};
+        ASAN_POISON_MEMORY_REGION(block, total);
+        ASAN_UNPOISON_MEMORY_REGION(ptr, count);
+#else
+        (void) count;
+#endif
+        return ptr;
+    }
+
+    void arena_block_deleted(char* ptr)
+    {
+#ifdef ARENA_ASAN
+        char* block = ptr - ARENA_REDZONE;
+        ASAN_UNPOISON_MEMORY_REGION(block, sizeof(arena_block_header));
+        arena_block_header* header = reinterpret_cast<arena_block_header*>(block);
+        if (header->deleted)
+        {
+            std::cerr << "double delete of arena memory " << static_cast<void*>(ptr) << std::endl;
+            std::abort();
+        }
+        header->deleted = 1;
+        ASAN_POISON_MEMORY_REGION(block, ARENA_REDZONE + header->count);
+#else
+        (void) ptr;
+#endif
+    }
+
+    // true if ptr came from an arena, which then is all there is to do
+    bool arena_deallocate(void* ptr)
+    {
+        size_t count = arena_region_count.load(std::memory_order_acquire);
+        char* p = static_cast<char*>(ptr);
+        for (size_t i = 0; i != count; ++i)
+        {
+            arena_region& r = arena_regions[i];
+            if (p >= r.base && p < r.base + ARENA_RESERVE)
+            {
+                arena_block_deleted(p);
+                r.live.fetch_sub(1, std::memory_order_release);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void* allocate(size_t count)
+    {
+        if (should_inject_fault())
+            throw std::bad_alloc();
+
+        if (current_arena)
+            if (void* ptr = arena_allocate(count))
+                return ptr;
+
+        void* ptr = malloc(count);
+        if (!ptr)
+            throw std::bad_alloc();
+
+        return ptr;
+    }
+
+    void deallocate(void* ptr)
+    {
+        if (!arena_deallocate(ptr))
+            free(ptr);
+    }
+
     thread_local bool disabled = false;
     thread_local fault_injection_context* context = nullptr;
     
@@ -134,46 +313,59 @@ fault_injection_disable::~fault_injection_disable()
     disabled = was_disabled;
 }
 
+allocation_arena::allocation_arena()
+    : region(acquire_arena_region())
+    , previous(current_arena)
+{
+    // with every region taken allocations just keep going to malloc
+    if (region)
+        current_arena = static_cast<arena_region*>(region);
+}
+
+allocation_arena::~allocation_arena()
+{
+    if (!region)
+        return;
+    current_arena = static_cast<arena_region*>(previous);
+    release_arena_region(static_cast<arena_region*>(region));
+}
+
+size_t allocation_arena::allocations() const
+{
+    return region ? static_cast<arena_region*>(region)->allocations : 0;
+}
+
+size_t allocation_arena::live_allocations() const
+{
+    return region ? static_cast<arena_region*>(region)->live.load(std::memory_order_acquire) : 0;
+}
+
 void* operator new(std::size_t count)
 {
-    if (should_inject_fault())
-        throw std::bad_alloc();
-    
-    void* ptr = malloc(count);
-    if (!ptr)
-        throw std::bad_alloc();
-    
-    return ptr;
+    return allocate(count);
 }
 
 void* operator new[](std::size_t count)
 {
-    if (should_inject_fault())
-        throw std::bad_alloc();
-    
-    void* ptr = malloc(count);
-    if (!ptr)
-        throw std::bad_alloc();
-    
-    return ptr;
+    return allocate(count);
 }
 
 void operator delete(void* ptr) noexcept
 {
-    free(ptr);
+    deallocate(ptr);
 }
 
 void operator delete[](void* ptr) noexcept
 {
-    free(ptr);
+    deallocate(ptr);
 }
 
 void operator delete(void* ptr, std::size_t) noexcept
 {
-    free(ptr);
+    deallocate(ptr);
 }
 
 void operator delete[](void* ptr, std::size_t) noexcept
 {
-    free(ptr);
+    deallocate(ptr);
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <functional>
 #include <stdexcept>
 
@@ -22,3 +23,23 @@ struct fault_injection_disable
 private:
     bool was_disabled;
 };
+
+// Opt-in bump allocation for a test scope: while an allocation_arena is alive, operator new on this
+// thread takes memory from a bump arena, operator delete of arena memory only does the bookkeeping,
+// and the whole arena is reset in one go when the scope ends. Fault injection works as before.
+// Allocations still live at that point (a leak, or e.g. a gtest failure message that outlives the
+// scope) keep the arena mapped so they stay valid; live_allocations() reports them.
+struct allocation_arena
+{
+    allocation_arena();
+    allocation_arena(allocation_arena const&) = delete;
+    allocation_arena& operator=(allocation_arena const&) = delete;
+    ~allocation_arena();
+
+    size_t allocations() const;
+    size_t live_allocations() const;
+
+private:
+    void* region;
+    void* previous;
+};
@@ -3,3 +3,229 @@
 using container = my::circular_buffer<counted>;
 
 #include "tests.inl"
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+TEST(mpmc_queue, fifo)
+{
+    my::mpmc_queue<std::string> q(5);
+    EXPECT_EQ(8u, q.max_size());
+
+    std::string out;
+    EXPECT_FALSE(q.try_pop(out));
+    for (int i = 0; i != 8; ++i)
+        EXPECT_TRUE(q.try_push(std::to_string(i)));
+    EXPECT_FALSE(q.try_push("full"));
+
+    // keep the ring going round a few times
+    for (int i = 8; i != 100; ++i)
+    {
+        ASSERT_TRUE(q.try_pop(out));
+        EXPECT_EQ(std::to_string(i - 8), out);
+        ASSERT_TRUE(q.try_push(std::to_string(i)));
+    }
+    for (int i = 92; i != 100; ++i)
+    {
+        ASSERT_TRUE(q.try_pop(out));
+        EXPECT_EQ(std::to_string(i), out);
+    }
+    EXPECT_FALSE(q.try_pop(out));
+}
+
+TEST(mpmc_queue, destroys_leftovers)
+{
+    my::mpmc_queue<std::string> q(4);
+    q.push(std::string(100, 'a'));
+    q.push(std::string(100, 'b'));
+    std::string out;
+    q.pop(out);
+    EXPECT_EQ(std::string(100, 'a'), out);
+    // the remaining string is freed by the destructor, the leak checker would notice otherwise
+}
+
+TEST(mpmc_queue, concurrent_per_producer_order)
+{
+    size_t const producers = 4, consumers = 4, per_producer = 50000;
+    my::mpmc_queue<size_t> q(64);
+    std::atomic<size_t> popped(0);
+    std::atomic<bool> ordered(true);
+    std::vector<std::atomic<size_t>> sums(producers);
+
+    std::vector<std::thread> ts;
+    for (size_t p = 0; p != producers; ++p)
+        ts.emplace_back([&q, p]
+        {
+            for (size_t i = 0; i != per_producer; ++i)
+                q.push(p * per_producer + i);
+        });
+    for (size_t c = 0; c != consumers; ++c)
+        ts.emplace_back([&]
+        {
+            // values of one producer must come out in the order it pushed them
+            std::vector<size_t> last(producers, 0);
+            std::vector<bool> seen(producers, false);
+            size_t val;
+            while (popped.load() != producers * per_producer)
+            {
+                if (!q.try_pop(val))
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                ++popped;
+                size_t p = val / per_producer;
+                if (seen[p] && val <= last[p])
+                    ordered = false;
+                seen[p] = true;
+                last[p] = val;
+                sums[p] += val;
+            }
+        });
+    for (std::thread& t : ts)
+        t.join();
+
+    EXPECT_TRUE(ordered);
+    for (size_t p = 0; p != producers; ++p)
+    {
+        size_t first = p * per_producer;
+        EXPECT_EQ(per_producer * first + per_producer * (per_producer - 1) / 2, sums[p]);
+    }
+    size_t out;
+    EXPECT_FALSE(q.try_pop(out));
+}
+
+TEST(work_stealing_deque, owner_lifo_thief_fifo)
+{
+    my::work_stealing_deque<int> d(4);
+    int out;
+    EXPECT_FALSE(d.pop_back(out));
+    EXPECT_FALSE(d.steal_front(out));
+
+    // past the initial capacity, so the array is resized on the way
+    for (int i = 0; i != 20; ++i)
+        d.push_back(i);
+    EXPECT_EQ(20u, d.size());
+
+    ASSERT_TRUE(d.steal_front(out));
+    EXPECT_EQ(0, out);
+    ASSERT_TRUE(d.pop_back(out));
+    EXPECT_EQ(19, out);
+    ASSERT_TRUE(d.steal_front(out));
+    EXPECT_EQ(1, out);
+
+    for (int i = 18; i != 1; --i)
+    {
+        ASSERT_TRUE(d.pop_back(out));
+        EXPECT_EQ(i, out);
+    }
+    EXPECT_TRUE(d.empty());
+    EXPECT_FALSE(d.pop_back(out));
+    EXPECT_FALSE(d.steal_front(out));
+}
+
+TEST(work_stealing_deque, concurrent_steal)
+{
+    size_t const n = 200000, thieves = 3;
+    my::work_stealing_deque<size_t> d(8);
+    std::vector<std::atomic<int>> taken(n);
+    std::atomic<bool> done(false);
+
+    std::vector<std::thread> ts;
+    for (size_t i = 0; i != thieves; ++i)
+        ts.emplace_back([&]
+        {
+            size_t val;
+            // shutdown: keep stealing until the owner is done and nothing is left
+            while (!done.load() || !d.empty())
+            {
+                if (d.steal_front(val))
+                    ++taken[val];
+            }
+        });
+
+    // the owner pushes in bursts and pops some back itself, so the array grows under the thieves
+    size_t val;
+    for (size_t i = 0; i != n; ++i)
+    {
+        d.push_back(i);
+        if (i % 3 == 0 && d.pop_back(val))
+            ++taken[val];
+    }
+    while (d.pop_back(val))
+        ++taken[val];
+    done = true;
+    for (std::thread& t : ts)
+        t.join();
+
+    size_t wrong = 0;
+    for (size_t i = 0; i != n; ++i)
+        wrong += taken[i] != 1;
+    EXPECT_EQ(0u, wrong);
+}
+
+namespace
+{
+    // wraps the ring twice and sums what is left through the iterators
+    constexpr int static_buffer_sum()
+    {
+        my::static_circular_buffer<int, 4> c;
+        for (int i = 1; i != 10; ++i)
+        {
+            if (c.full())
+                c.pop_front();
+            c.push_back(i);
+        }
+        c.pop_back();
+        c.push_front(100);
+
+        int sum = 0;
+        for (auto it = c.begin(); it != c.end(); ++it)
+            sum += *it;
+        return sum + int(c.size()) * 1000 + c.front();
+    }
+
+    static_assert(static_buffer_sum() == 100 + 6 + 7 + 8 + 4000 + 100, "static_circular_buffer must work in constant expressions");
+    static_assert(my::static_circular_buffer<int, 8>::capacity() == 8, "");
+}
+
+TEST(static_circular_buffer, wraparound)
+{
+    counted::no_new_instances_guard g;
+
+    my::static_circular_buffer<counted, 4> c;
+    mass_push_back(c, {1, 2, 3});
+    c.push_front(0);
+    EXPECT_TRUE(c.full());
+    expect_eq(c, {0, 1, 2, 3});
+
+    for (int i = 4; i != 11; ++i)
+    {
+        c.pop_front();
+        c.push_back(i);
+    }
+    expect_eq(c, {7, 8, 9, 10});
+    expect_reverse_eq(c, {10, 9, 8, 7});
+    EXPECT_EQ(8, c[1]);
+    EXPECT_EQ(10, c.back());
+}
+
+TEST(static_circular_buffer, copy)
+{
+    counted::no_new_instances_guard g;
+
+    my::static_circular_buffer<counted, 4> c;
+    mass_push_back(c, {1, 2, 3, 4});
+    c.pop_front();
+    c.push_back(5);
+
+    my::static_circular_buffer<counted, 4> c2(c);
+    expect_eq(c2, {2, 3, 4, 5});
+    c2.pop_back();
+    c = c2;
+    expect_eq(c, {2, 3, 4});
+    c.clear();
+    EXPECT_TRUE(c.empty());
+    expect_eq(c2, {2, 3, 4});
+}
@@ -6,10 +6,15 @@
 #define CIRCULAR_BUFFER_CIRCULAR_BUFFER_H
 
 #include <assert.h>
+#include <atomic>
 #include <cstddef>
 #include <utility>
 #include <iterator>
+#include <thread>
 #include <type_traits>
+#include <vector>
+
+#include "ring_spans.h"
 
 namespace my {
     template<typename T>
@@ -41,11 +46,19 @@ namespace my {
             T *ptr;
             T *extreme_left;
             T *extreme_right;
+            // element 0 of the buffer, so that distances and comparisons work across the wrap
+            T *first;
 
-            iterator_buf(T *ptr, T *extreme_left, T *extreme_right) :
+            iterator_buf(T *ptr, T *extreme_left, T *extreme_right, T *first) :
                     ptr(ptr),
                     extreme_left(extreme_left),
-                    extreme_right(extreme_right) {}
+                    extreme_right(extreme_right),
+                    first(first) {}
+
+            difference_type index() const {
+                difference_type ind = ptr - first;
+                return ind < 0 ? ind + (extreme_right - extreme_left) : ind;
+            }
 
         public:
             explicit iterator_buf() {}
@@ -54,7 +67,8 @@ namespace my {
             iterator_buf(iterator_buf<is_const2> const &other)
                     : ptr(other.ptr),
                       extreme_left(other.extreme_left),
-                      extreme_right(other.extreme_right) {}
+                      extreme_right(other.extreme_right),
+                      first(other.first) {}
 
 
             reference operator*() {
@@ -127,13 +141,13 @@ namespace my {
             }
 
             iterator_buf operator+(ptrdiff_t shift) {
-                iterator_buf ret(ptr, extreme_left, extreme_right);
+                iterator_buf ret(ptr, extreme_left, extreme_right, first);
                 ret += shift;
                 return ret;
             }
 
             iterator_buf operator-(ptrdiff_t shift) {
-                iterator_buf ret(ptr, extreme_left, extreme_right);
+                iterator_buf ret(ptr, extreme_left, extreme_right, first);
                 ret -= shift;
                 return ret;
             }
@@ -158,24 +172,24 @@ namespace my {
                 return ptr != it2.ptr;
             }
 
-            difference_type operator-(iterator_buf const &it2) {
-                return ptr - it2.ptr;
+            difference_type operator-(iterator_buf const &it2) const {
+                return index() - it2.index();
             }
 
-            bool operator>(iterator_buf const &it2) {
-                return (ptr - it2.ptr) > 0;
+            bool operator>(iterator_buf const &it2) const {
+                return index() > it2.index();
             }
 
-            bool operator>=(iterator_buf const &it2) {
-                return (ptr - it2.ptr) >= 0;
+            bool operator>=(iterator_buf const &it2) const {
+                return index() >= it2.index();
             }
 
-            bool operator<(iterator_buf const &it2) {
-                return (ptr - it2.ptr) < 0;
+            bool operator<(iterator_buf const &it2) const {
+                return index() < it2.index();
             }
 
-            bool operator<=(iterator_buf const &it2) {
-                return (ptr - it2.ptr) <= 0;
+            bool operator<=(iterator_buf const &it2) const {
+                return index() <= it2.index();
             }
         };
 
@@ -220,10 +234,10 @@ namespace my {
 
         iterator begin() {
             if (capacity == 0) {
-                return iterator(nullptr, nullptr, nullptr);
+                return iterator(nullptr, nullptr, nullptr, nullptr);
             }
 
-            return iterator(data + start, data, data + capacity);
+            return iterator(data + start, data, data + capacity, data + start);
         }
 
         reverse_iterator rbegin() {
@@ -232,9 +246,9 @@ namespace my {
 
         iterator end() {
             if (capacity == 0) {
-                return iterator(nullptr, nullptr, nullptr);
+                return iterator(nullptr, nullptr, nullptr, nullptr);
             }
-            return iterator(data + (start + size_) % capacity, data, data + capacity);
+            return iterator(data + (start + size_) % capacity, data, data + capacity, data + start);
         }
 
         reverse_iterator rend() {
@@ -243,9 +257,9 @@ namespace my {
 
         const_iterator begin() const {
             if (capacity == 0) {
-                return iterator(nullptr, nullptr, nullptr);
+                return iterator(nullptr, nullptr, nullptr, nullptr);
             }
-            return const_iterator(data + start, data, data + capacity);
+            return const_iterator(data + start, data, data + capacity, data + start);
         }
 
         const_reverse_iterator rbegin() const {
@@ -254,9 +268,9 @@ namespace my {
 
         const_iterator end() const {
             if (capacity == 0) {
-                return iterator(nullptr, nullptr, nullptr);
+                return iterator(nullptr, nullptr, nullptr, nullptr);
             }
-            return const_iterator(data + (start + size_) % capacity, data, data + capacity);
+            return const_iterator(data + (start + size_) % capacity, data, data + capacity, data + start);
         }
 
         const_reverse_iterator rend() const {
@@ -266,6 +280,10 @@ namespace my {
         circular_buffer() noexcept : capacity(0), size_(0), start(0), data(nullptr) {}
 
         circular_buffer(circular_buffer const &other) : capacity(other.capacity), size_(other.size_), start(0) {
+            if (capacity == 0) {
+                data = nullptr;
+                return;
+            }
             data = (T *) operator new(other.capacity * sizeof(T));
             size_t i = 0;
             try {
@@ -402,6 +420,14 @@ namespace my {
             return size_;
         }
 
+        ring_spans<T> as_spans() noexcept {
+            return make_ring_spans(data, capacity, start, size_);
+        }
+
+        ring_spans<T const> as_spans() const noexcept {
+            return make_ring_spans<T const>(data, capacity, start, size_);
+        }
+
         T &operator[](size_t ind) {
             assert(ind < size_ && "can'r [], ind > size");
             return data[(start + ind) % capacity];
@@ -413,9 +439,8 @@ namespace my {
         }
 
         iterator erase(iterator it) {
-            iterator ret;
-            if (it - begin() < (int) size_ / 2) {
-                ret = it + 1;
+            size_t pos = it - begin();
+            if (pos < size_ / 2) {
                 while (it != begin()) {
                     iterator next = it - 1;
                     std::swap(*it, *next);
@@ -423,7 +448,6 @@ namespace my {
                 }
                 pop_front();
             } else {
-                ret = it;
                 it++;
                 while (it != end()) {
                     auto prev = it - 1;
@@ -432,7 +456,7 @@ namespace my {
                 }
                 pop_back();
             }
-            return ret;
+            return begin() + pos;
         }
 
         iterator insert(iterator it, T const &val) {
@@ -443,19 +467,620 @@ namespace my {
                 for (size_t i = 0; i < pos; ++i) {
                     std::swap(data[(start + i) % capacity], data[(start + i + 1) % capacity]);
                 }
-                ret = iterator(data + (start + pos) % capacity, data, data + capacity);
+                ret = iterator(data + (start + pos) % capacity, data, data + capacity, data + start);
             } else {
                 push_back(val);
                 for (size_t i = size_ - 1; i > pos; --i) {
                     std::swap(data[(start + i) % capacity], data[(start + i - 1) % capacity]);
                 }
-                ret = iterator(data + (start + pos) % capacity, data, data + capacity);
+                ret = iterator(data + (start + pos) % capacity, data, data + capacity, data + start);
             }
             return ret;
         }
 
         friend void swap<T>(circular_buffer &, circular_buffer &) noexcept;
     };
+
+    // Slots of static_circular_buffer. Trivial T lives in a plain array, so the buffer is a literal type
+    // and usable in constant expressions; anything else gets raw aligned bytes and is constructed in place.
+    template<typename T, size_t N, bool trivial = std::is_trivial<T>::value>
+    struct static_ring_storage {
+        T slots[N];
+        size_t start;
+        size_t size_;
+
+        constexpr static_ring_storage() noexcept : slots(), start(0), size_(0) {}
+
+        constexpr T *slot(size_t i) noexcept {
+            return slots + i;
+        }
+
+        constexpr T const *slot(size_t i) const noexcept {
+            return slots + i;
+        }
+
+        constexpr void construct(size_t i, T const &val) noexcept {
+            slots[i] = val;
+        }
+
+        constexpr void destroy(size_t) noexcept {}
+    };
+
+    template<typename T, size_t N>
+    struct static_ring_storage<T, N, false> {
+        alignas(T) unsigned char bytes[sizeof(T) * N];
+        size_t start;
+        size_t size_;
+
+        static_ring_storage() noexcept : start(0), size_(0) {}
+
+        static_ring_storage(static_ring_storage const &other) : start(0), size_(0) {
+            copy_from(other);
+        }
+
+        // basic guarantee only: the old elements are gone before the copy can throw
+        static_ring_storage &operator=(static_ring_storage const &other) {
+            if (this != &other) {
+                destroy_all();
+                copy_from(other);
+            }
+            return *this;
+        }
+
+        ~static_ring_storage() {
+            destroy_all();
+        }
+
+        T *slot(size_t i) noexcept {
+            return reinterpret_cast<T *>(bytes) + i;
+        }
+
+        T const *slot(size_t i) const noexcept {
+            return reinterpret_cast<T const *>(bytes) + i;
+        }
+
+        void construct(size_t i, T const &val) {
+            new(slot(i)) T(val);
+        }
+
+        void destroy(size_t i) noexcept {
+            slot(i)->~T();
+        }
+
+    private:
+        void destroy_all() noexcept {
+            for (; size_ != 0; --size_) {
+                destroy((start + size_ - 1) & (N - 1));
+            }
+            start = 0;
+        }
+
+        // the copy is laid out from slot 0
+        void copy_from(static_ring_storage const &other) {
+            for (size_t i = 0; i < other.size_; ++i) {
+                construct(i, *other.slot((other.start + i) & (N - 1)));
+                ++size_;
+            }
+        }
+    };
+
+    // Fixed-capacity ring with its storage inside the object: no heap at all, the container can live
+    // on the stack or inside another object. N is a power of two, so every wrap is a mask with a constant.
+    // Unlike circular_buffer all N slots are usable, hence full() and index-based iterators.
+    template<typename T, size_t N>
+    struct static_circular_buffer {
+        static_assert(N != 0 && (N & (N - 1)) == 0, "N must be a power of two");
+
+        template<bool is_const>
+        struct iterator_buf {
+            friend static_circular_buffer;
+
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = T;
+            using difference_type = ptrdiff_t;
+            using pointer = std::conditional_t<is_const, value_type const *, value_type *>;
+            using reference = std::conditional_t<is_const, value_type const &, value_type &>;
+
+        private:
+            using owner = std::conditional_t<is_const, static_circular_buffer const, static_circular_buffer>;
+
+            owner *buf;
+            size_t ind;
+
+            constexpr iterator_buf(owner *buf, size_t ind) noexcept : buf(buf), ind(ind) {}
+
+        public:
+            constexpr iterator_buf() noexcept : buf(nullptr), ind(0) {}
+
+            template<bool other_const, typename = std::enable_if_t<is_const && !other_const>>
+            constexpr iterator_buf(iterator_buf<other_const> const &other) noexcept : buf(other.buf), ind(other.ind) {}
+
+            constexpr reference operator*() const noexcept {
+                return (*buf)[ind];
+            }
+
+            constexpr pointer operator->() const noexcept {
+                return &(*buf)[ind];
+            }
+
+            constexpr reference operator[](difference_type shift) const noexcept {
+                return (*buf)[ind + shift];
+            }
+
+            constexpr iterator_buf &operator++() noexcept {
+                ++ind;
+                return *this;
+            }
+
+            constexpr iterator_buf operator++(int) noexcept {
+                iterator_buf ret = *this;
+                ++ind;
+                return ret;
+            }
+
+            constexpr iterator_buf &operator--() noexcept {
+                --ind;
+                return *this;
+            }
+
+            constexpr iterator_buf operator--(int) noexcept {
+                iterator_buf ret = *this;
+                --ind;
+                return ret;
+            }
+
+            constexpr iterator_buf &operator+=(difference_type shift) noexcept {
+                ind += shift;
+                return *this;
+            }
+
+            constexpr iterator_buf &operator-=(difference_type shift) noexcept {
+                ind -= shift;
+                return *this;
+            }
+
+            constexpr iterator_buf operator+(difference_type shift) const noexcept {
+                return iterator_buf(buf, ind + shift);
+            }
+
+            constexpr iterator_buf operator-(difference_type shift) const noexcept {
+                return iterator_buf(buf, ind - shift);
+            }
+
+            constexpr difference_type operator-(iterator_buf const &it2) const noexcept {
+                return (difference_type) ind - (difference_type) it2.ind;
+            }
+
+            constexpr bool operator==(iterator_buf const &it2) const noexcept {
+                return buf == it2.buf && ind == it2.ind;
+            }
+
+            constexpr bool operator!=(iterator_buf const &it2) const noexcept {
+                return !(*this == it2);
+            }
+
+            constexpr bool operator<(iterator_buf const &it2) const noexcept {
+                return ind < it2.ind;
+            }
+
+            constexpr bool operator>(iterator_buf const &it2) const noexcept {
+                return it2 < *this;
+            }
+
+            constexpr bool operator<=(iterator_buf const &it2) const noexcept {
+                return !(it2 < *this);
+            }
+
+            constexpr bool operator>=(iterator_buf const &it2) const noexcept {
+                return !(*this < it2);
+            }
+
+            template<bool>
+            friend struct iterator_buf;
+        };
+
+    private:
+        static constexpr size_t mask = N - 1;
+
+        static_ring_storage<T, N> storage;
+
+    public:
+        typedef iterator_buf<false> iterator;
+        typedef iterator_buf<true> const_iterator;
+        typedef std::reverse_iterator<iterator> reverse_iterator;
+        typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+        constexpr static_circular_buffer() noexcept = default;
+
+        static constexpr size_t capacity() noexcept {
+            return N;
+        }
+
+        constexpr size_t size() const noexcept {
+            return storage.size_;
+        }
+
+        constexpr bool empty() const noexcept {
+            return storage.size_ == 0;
+        }
+
+        constexpr bool full() const noexcept {
+            return storage.size_ == N;
+        }
+
+        constexpr void push_back(T const &val) {
+            assert(!full() && "can't push_back(), buffer is full");
+            storage.construct((storage.start + storage.size_) & mask, val);
+            ++storage.size_;
+        }
+
+        constexpr void push_front(T const &val) {
+            assert(!full() && "can't push_front(), buffer is full");
+            size_t new_start = (storage.start - 1) & mask;
+            storage.construct(new_start, val);
+            storage.start = new_start;
+            ++storage.size_;
+        }
+
+        constexpr void pop_back() noexcept {
+            assert(storage.size_ && "can't pop_back(), size == 0");
+            --storage.size_;
+            storage.destroy((storage.start + storage.size_) & mask);
+        }
+
+        constexpr void pop_front() noexcept {
+            assert(storage.size_ && "can't pop_front(), size == 0");
+            storage.destroy(storage.start);
+            storage.start = (storage.start + 1) & mask;
+            --storage.size_;
+        }
+
+        constexpr void clear() noexcept {
+            while (!empty()) {
+                pop_back();
+            }
+        }
+
+        constexpr T &operator[](size_t ind) noexcept {
+            assert(ind < storage.size_ && "can't [], ind >= size");
+            return *storage.slot((storage.start + ind) & mask);
+        }
+
+        constexpr T const &operator[](size_t ind) const noexcept {
+            assert(ind < storage.size_ && "can't [], ind >= size");
+            return *storage.slot((storage.start + ind) & mask);
+        }
+
+        constexpr T &front() noexcept {
+            return (*this)[0];
+        }
+
+        constexpr T const &front() const noexcept {
+            return (*this)[0];
+        }
+
+        constexpr T &back() noexcept {
+            return (*this)[storage.size_ - 1];
+        }
+
+        constexpr T const &back() const noexcept {
+            return (*this)[storage.size_ - 1];
+        }
+
+        constexpr iterator begin() noexcept {
+            return iterator(this, 0);
+        }
+
+        constexpr iterator end() noexcept {
+            return iterator(this, storage.size_);
+        }
+
+        constexpr const_iterator begin() const noexcept {
+            return const_iterator(this, 0);
+        }
+
+        constexpr const_iterator end() const noexcept {
+            return const_iterator(this, storage.size_);
+        }
+
+        reverse_iterator rbegin() noexcept {
+            return reverse_iterator(end());
+        }
+
+        reverse_iterator rend() noexcept {
+            return reverse_iterator(begin());
+        }
+
+        const_reverse_iterator rbegin() const noexcept {
+            return const_reverse_iterator(end());
+        }
+
+        const_reverse_iterator rend() const noexcept {
+            return const_reverse_iterator(begin());
+        }
+
+        ring_spans<T> as_spans() noexcept {
+            return make_ring_spans(storage.slot(0), N, storage.start, storage.size_);
+        }
+
+        ring_spans<T const> as_spans() const noexcept {
+            return make_ring_spans<T const>(storage.slot(0), N, storage.start, storage.size_);
+        }
+    };
+
+    // Bounded multi-producer/multi-consumer queue (D. Vyukov's design).
+    // Same ring as circular_buffer, but the capacity is a power of two and every cell carries
+    // a sequence number telling which lap of the ring it is ready for:
+    // sequence == pos means free for the producer of pos, sequence == pos + 1 means filled for its consumer.
+    // Producers and consumers only contend on their own position counter, never on a lock.
+    template<typename T>
+    struct mpmc_queue {
+        static_assert(std::is_nothrow_move_constructible<T>::value && std::is_nothrow_move_assignable<T>::value,
+                      "a claimed cell can't be given back, so moving values in and out must not throw");
+
+    private:
+        static constexpr size_t cache_line = 64;
+
+        struct cell {
+            std::atomic<size_t> sequence;
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+            T *value() {
+                return reinterpret_cast<T *>(&storage);
+            }
+        };
+
+        size_t capacity;
+        size_t mask;
+        cell *cells;
+
+        alignas(cache_line) std::atomic<size_t> enqueue_pos;
+        alignas(cache_line) std::atomic<size_t> dequeue_pos;
+
+        cell *claim_for_push(size_t &pos) {
+            pos = enqueue_pos.load(std::memory_order_relaxed);
+            for (;;) {
+                cell *c = cells + (pos & mask);
+                ptrdiff_t dif = (ptrdiff_t) c->sequence.load(std::memory_order_acquire) - (ptrdiff_t) pos;
+                if (dif == 0) {
+                    if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        return c;
+                    }
+                } else if (dif < 0) {
+                    return nullptr;
+                } else {
+                    pos = enqueue_pos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        cell *claim_for_pop(size_t &pos) {
+            pos = dequeue_pos.load(std::memory_order_relaxed);
+            for (;;) {
+                cell *c = cells + (pos & mask);
+                ptrdiff_t dif = (ptrdiff_t) c->sequence.load(std::memory_order_acquire) - (ptrdiff_t) (pos + 1);
+                if (dif == 0) {
+                    if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        return c;
+                    }
+                } else if (dif < 0) {
+                    return nullptr;
+                } else {
+                    pos = dequeue_pos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+    public:
+        explicit mpmc_queue(size_t min_capacity) : capacity(2), enqueue_pos(0), dequeue_pos(0) {
+            while (capacity < min_capacity) {
+                capacity *= 2;
+            }
+            mask = capacity - 1;
+            cells = new cell[capacity];
+            for (size_t i = 0; i < capacity; ++i) {
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        mpmc_queue(mpmc_queue const &) = delete;
+        mpmc_queue &operator=(mpmc_queue const &) = delete;
+
+        ~mpmc_queue() {
+            size_t end = enqueue_pos.load(std::memory_order_relaxed);
+            for (size_t pos = dequeue_pos.load(std::memory_order_relaxed); pos != end; ++pos) {
+                cells[pos & mask].value()->~T();
+            }
+            delete[] cells;
+        }
+
+        size_t max_size() const noexcept {
+            return capacity;
+        }
+
+        bool try_push(T const &val) {
+            T copy(val);
+            size_t pos;
+            cell *c = claim_for_push(pos);
+            if (c == nullptr) {
+                return false;
+            }
+            new(c->value()) T(std::move(copy));
+            c->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool try_pop(T &out) noexcept {
+            size_t pos;
+            cell *c = claim_for_pop(pos);
+            if (c == nullptr) {
+                return false;
+            }
+            out = std::move(*c->value());
+            c->value()->~T();
+            c->sequence.store(pos + capacity, std::memory_order_release);
+            return true;
+        }
+
+        // blocking versions: spin while the queue is full/empty, yielding the cpu between attempts
+        void push(T const &val) {
+            while (!try_push(val)) {
+                std::this_thread::yield();
+            }
+        }
+
+        void pop(T &out) noexcept {
+            while (!try_pop(out)) {
+                std::this_thread::yield();
+            }
+        }
+    };
+
+    // Chase-Lev work-stealing deque (in the C11 formulation by Le, Pop, Cohen and Zappa Nardelli).
+    // The owner thread pushes and pops at the back, any number of thieves steal from the front.
+    // Like circular_buffer the storage doubles when full (see resize_x2), but thieves may still be
+    // reading the old array, so it is retired and freed only once no thief is inside steal_front().
+    template<typename T>
+    struct work_stealing_deque {
+        static_assert(std::is_trivially_copyable<T>::value, "slots are read and written as atomics");
+
+    private:
+        static constexpr size_t cache_line = 64;
+
+        struct array {
+            size_t capacity;
+            size_t mask;
+            std::atomic<T> *data;
+
+            explicit array(size_t capacity) : capacity(capacity), mask(capacity - 1), data(new std::atomic<T>[capacity]) {}
+
+            ~array() {
+                delete[] data;
+            }
+
+            T get(int64_t ind) const noexcept {
+                return data[ind & mask].load(std::memory_order_relaxed);
+            }
+
+            void put(int64_t ind, T const &val) noexcept {
+                data[ind & mask].store(val, std::memory_order_relaxed);
+            }
+        };
+
+        alignas(cache_line) std::atomic<int64_t> top;
+        alignas(cache_line) std::atomic<int64_t> bottom;
+        std::atomic<array *> buf;
+        std::vector<array *> retired; // owner only
+        alignas(cache_line) std::atomic<size_t> active_thieves;
+
+        array *resize_x2(array *old, int64_t t, int64_t b) {
+            array *bigger = new array(old->capacity * 2);
+            for (int64_t i = t; i < b; ++i) {
+                bigger->put(i, old->get(i));
+            }
+            retired.push_back(old);
+            buf.store(bigger, std::memory_order_seq_cst);
+            reclaim();
+            return bigger;
+        }
+
+        // a thief registers itself before loading buf, so once the count is seen at zero
+        // every thief that could have loaded a retired array is gone
+        void reclaim() {
+            if (active_thieves.load(std::memory_order_seq_cst) != 0) {
+                return;
+            }
+            for (array *a : retired) {
+                delete a;
+            }
+            retired.clear();
+        }
+
+    public:
+        explicit work_stealing_deque(size_t min_capacity = 64) : top(0), bottom(0), active_thieves(0) {
+            size_t capacity = 2;
+            while (capacity < min_capacity) {
+                capacity *= 2;
+            }
+            buf.store(new array(capacity), std::memory_order_relaxed);
+        }
+
+        work_stealing_deque(work_stealing_deque const &) = delete;
+        work_stealing_deque &operator=(work_stealing_deque const &) = delete;
+
+        ~work_stealing_deque() {
+            for (array *a : retired) {
+                delete a;
+            }
+            delete buf.load(std::memory_order_relaxed);
+        }
+
+        // racy when called concurrently with the owner, exact otherwise
+        size_t size() const noexcept {
+            int64_t b = bottom.load(std::memory_order_relaxed);
+            int64_t t = top.load(std::memory_order_relaxed);
+            return b > t ? size_t(b - t) : 0;
+        }
+
+        bool empty() const noexcept {
+            return size() == 0;
+        }
+
+        // owner only
+        void push_back(T const &val) {
+            int64_t b = bottom.load(std::memory_order_relaxed);
+            int64_t t = top.load(std::memory_order_acquire);
+            array *a = buf.load(std::memory_order_relaxed);
+            if (b - t > (int64_t) a->capacity - 1) {
+                a = resize_x2(a, t, b);
+            }
+            a->put(b, val);
+            std::atomic_thread_fence(std::memory_order_release);
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        // owner only
+        bool pop_back(T &out) noexcept {
+            int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+            array *a = buf.load(std::memory_order_relaxed);
+            bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = top.load(std::memory_order_relaxed);
+
+            if (t > b) {
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+            out = a->get(b);
+            if (t == b) {
+                // last element: race against thieves for it
+                bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return won;
+            }
+            return true;
+        }
+
+        // any thread; fails when the deque is empty or another thread took the element first
+        bool steal_front(T &out) noexcept {
+            active_thieves.fetch_add(1, std::memory_order_seq_cst);
+            int64_t t = top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t b = bottom.load(std::memory_order_acquire);
+
+            bool stolen = false;
+            if (t < b) {
+                array *a = buf.load(std::memory_order_seq_cst);
+                T val = a->get(t);
+                if (top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    out = val;
+                    stolen = true;
+                }
+            }
+            active_thieves.fetch_sub(1, std::memory_order_release);
+            return stolen;
+        }
+    };
 }
 
 #endif //CIRCULAR_BUFFER_CIRCULAR_BUFFER_H
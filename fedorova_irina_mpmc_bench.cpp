@@ -0,0 +1,106 @@
+#include "fedorova_irina.h"
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    size_t const OPS = 1 << 22;
+    size_t const QUEUE_SIZE = 1024;
+
+    struct locked_queue
+    {
+        explicit locked_queue(size_t max_size)
+            : max_size(max_size)
+        {}
+
+        bool try_push(size_t val)
+        {
+            std::lock_guard<std::mutex> lg(m);
+            if (buf.size() == max_size)
+                return false;
+            buf.push_back(val);
+            return true;
+        }
+
+        bool try_pop(size_t& out)
+        {
+            std::lock_guard<std::mutex> lg(m);
+            if (buf.empty())
+                return false;
+            out = buf.front();
+            buf.pop_front();
+            return true;
+        }
+
+    private:
+        std::mutex m;
+        size_t max_size;
+        my::circular_buffer<size_t> buf;
+    };
+
+    // threads / 2 producers and the rest consumers pass OPS values through q;
+    // a single thread alternates push and pop
+    template <typename Queue>
+    double run(size_t threads)
+    {
+        Queue q(QUEUE_SIZE);
+        size_t producers = threads == 1 ? 1 : threads / 2;
+        size_t consumers = threads == 1 ? 0 : threads - producers;
+        std::atomic<size_t> checksum(0);
+
+        auto start = std::chrono::steady_clock::now();
+        if (consumers == 0)
+        {
+            size_t sum = 0, out;
+            for (size_t i = 0; i != OPS; ++i)
+            {
+                while (!q.try_push(i))
+                    std::this_thread::yield();
+                while (!q.try_pop(out))
+                    std::this_thread::yield();
+                sum += out;
+            }
+            checksum = sum;
+        }
+        else
+        {
+            std::vector<std::thread> ts;
+            for (size_t p = 0; p != producers; ++p)
+                ts.emplace_back([&q, p, producers]
+                {
+                    for (size_t i = p; i < OPS; i += producers)
+                        while (!q.try_push(i))
+                            std::this_thread::yield();
+                });
+            for (size_t c = 0; c != consumers; ++c)
+                ts.emplace_back([&q, &checksum, c, consumers]
+                {
+                    size_t sum = 0, out;
+                    for (size_t i = c; i < OPS; i += consumers)
+                    {
+                        while (!q.try_pop(out))
+                            std::this_thread::yield();
+                        sum += out;
+                    }
+                    checksum += sum;
+                });
+            for (std::thread& t : ts)
+                t.join();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (checksum != OPS * (OPS - 1) / 2)
+            std::fprintf(stderr, "checksum mismatch\n");
+        return OPS / elapsed.count() / 1e6;
+    }
+}
+
+int main()
+{
+    std::printf("%8s %16s %16s\n", "threads", "mpmc_queue Mops", "mutex Mops");
+    for (size_t threads = 1; threads <= 64; threads *= 2)
+        std::printf("%8zu %16.2f %16.2f\n", threads, run<my::mpmc_queue<size_t>>(threads), run<locked_queue>(threads));
+}
@@ -0,0 +1,122 @@
+#include "fedorova_irina.h"
+#include "shelepov_anton.h"
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    int64_t const TASKS = 1 << 21;
+
+    struct locked_deque
+    {
+        void push_back(int64_t val)
+        {
+            std::lock_guard<std::mutex> lg(m);
+            d.push_back(val);
+        }
+
+        bool pop_back(int64_t& out)
+        {
+            std::lock_guard<std::mutex> lg(m);
+            if (d.empty())
+                return false;
+            out = d.back();
+            d.pop_back();
+            return true;
+        }
+
+        bool steal_front(int64_t& out)
+        {
+            std::lock_guard<std::mutex> lg(m);
+            if (d.empty())
+                return false;
+            out = d.front();
+            d.pop_front();
+            return true;
+        }
+
+    private:
+        std::mutex m;
+        deque<int64_t> d;
+    };
+
+    // a tiny bit of work per task, so that the deque operations dominate
+    int64_t run_task(int64_t task)
+    {
+        return task ^ (task >> 3);
+    }
+
+    // one owner pushes TASKS tasks and runs every fourth one itself,
+    // threads - 1 thieves steal from the front until the owner is done and the deque is drained
+    template <typename Deque>
+    double run(size_t threads)
+    {
+        Deque d;
+        std::atomic<bool> done(false);
+        std::atomic<int64_t> processed(0), checksum(0);
+
+        auto thief = [&]
+        {
+            int64_t count = 0, sum = 0, task;
+            for (;;)
+            {
+                if (d.steal_front(task))
+                {
+                    sum += run_task(task);
+                    ++count;
+                }
+                else if (done.load())
+                    break;
+                else
+                    std::this_thread::yield();
+            }
+            processed += count;
+            checksum += sum;
+        };
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> thieves;
+        for (size_t i = 1; i < threads; ++i)
+            thieves.emplace_back(thief);
+
+        int64_t count = 0, sum = 0, task;
+        for (int64_t i = 0; i != TASKS; ++i)
+        {
+            d.push_back(i);
+            if (i % 4 == 3 && d.pop_back(task))
+            {
+                sum += run_task(task);
+                ++count;
+            }
+        }
+        while (d.pop_back(task))
+        {
+            sum += run_task(task);
+            ++count;
+        }
+        done = true;
+        for (std::thread& t : thieves)
+            t.join();
+        thief();
+        processed += count;
+        checksum += sum;
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        int64_t expected = 0;
+        for (int64_t i = 0; i != TASKS; ++i)
+            expected += run_task(i);
+        if (processed != TASKS || checksum != expected)
+            std::fprintf(stderr, "lost or duplicated tasks\n");
+        return TASKS / elapsed.count() / 1e6;
+    }
+}
+
+int main()
+{
+    std::printf("%8s %22s %16s\n", "threads", "work_stealing Mtasks", "mutex Mtasks");
+    for (size_t threads = 1; threads <= 64; threads *= 2)
+        std::printf("%8zu %22.2f %16.2f\n", threads, run<my::work_stealing_deque<int64_t>>(threads), run<locked_deque>(threads));
+}
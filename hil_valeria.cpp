@@ -3,3 +3,89 @@
 using container = circ_buff<counted>;
 
 #include "tests.inl"
+
+// int is trivially copyable, so insert and erase move the elements with memmove, one contiguous
+// chunk at a time. The buffer below has capacity 16 and holds 14 elements starting at slot head,
+// so for most heads the contents wrap and the chunks have to be split at the wrap point.
+namespace
+{
+    circ_buff<int> rotated_buffer(size_t head)
+    {
+        circ_buff<int> c;
+        for (int i = 0; i != 15; ++i)
+            c.push_back(i);
+        c.pop_back();
+        for (size_t i = 0; i != head; ++i)
+        {
+            c.push_back(c.front());
+            c.pop_front();
+        }
+        return c;
+    }
+
+    std::vector<int> int_contents(circ_buff<int> const& c)
+    {
+        return std::vector<int>(c.begin(), c.end());
+    }
+}
+
+TEST(trivially_copyable, insert_middle_wrapped)
+{
+    size_t wrapped = 0;
+    for (size_t head = 0; head != 16; ++head)
+    {
+        for (size_t pos = 0; pos <= 14; ++pos)
+        {
+            circ_buff<int> c = rotated_buffer(head);
+            if (c.as_spans().array_two.size() != 0)
+                ++wrapped;
+            std::vector<int> expected = int_contents(c);
+
+            auto it = c.insert(c.begin() + pos, 100);
+            expected.insert(expected.begin() + pos, 100);
+            EXPECT_EQ(100, *it);
+            EXPECT_EQ(expected, int_contents(c)) << "head " << head << ", pos " << pos;
+        }
+    }
+    EXPECT_LT(0u, wrapped);
+}
+
+TEST(trivially_copyable, erase_middle_wrapped)
+{
+    for (size_t head = 0; head != 16; ++head)
+    {
+        for (size_t pos = 0; pos != 14; ++pos)
+        {
+            circ_buff<int> c = rotated_buffer(head);
+            std::vector<int> expected = int_contents(c);
+
+            auto it = c.erase(c.begin() + pos);
+            expected.erase(expected.begin() + pos);
+            EXPECT_EQ(expected, int_contents(c)) << "head " << head << ", pos " << pos;
+            if (pos != expected.size())
+                EXPECT_EQ(expected[pos], *it);
+        }
+    }
+}
+
+TEST(trivially_copyable, insert_erase_sequence)
+{
+    circ_buff<int> c = rotated_buffer(9);
+    std::vector<int> expected = int_contents(c);
+    for (int i = 0; i != 200; ++i)
+    {
+        size_t pos = size_t(i * 7) % (expected.size() + 1);
+        if (i % 2 == 0 || expected.empty())
+        {
+            c.insert(c.begin() + pos, 1000 + i);
+            expected.insert(expected.begin() + pos, 1000 + i);
+        }
+        else
+        {
+            pos %= expected.size();
+            c.erase(c.begin() + pos);
+            expected.erase(expected.begin() + pos);
+        }
+        ASSERT_EQ(expected, int_contents(c)) << "step " << i;
+    }
+}
@@ -5,9 +5,13 @@
 #ifndef CIRCULAR_BUFFER_CIRCULAR_BUFFER_H
 #define CIRCULAR_BUFFER_CIRCULAR_BUFFER_H
 
+#include <algorithm>
+#include <cstring>
 #include <iterator>
 #include <type_traits>
 
+#include "ring_spans.h"
+
 template<typename T>
 struct circ_buff;
 
@@ -136,34 +140,40 @@ struct circ_buff {
         }
     }
 
+    ring_spans<T> as_spans() {
+        return make_ring_spans(buffer, capacity, head_, size());
+    }
+
+    ring_spans<const T> as_spans() const {
+        return make_ring_spans<const T>(buffer, capacity, head_, size());
+    }
+
     iterator insert(const_iterator pos, T const &value) {
-        if (dist(head_, pos - begin()) + 1 < dist(pos - begin(), tail_)) {
+        size_t ind = pos - begin();
+        if (ind < size() - ind) {
             push_front(value);
-            for (size_t i = 0; i + begin() < pos; i++) {
-                std::swap(operator[](i), operator[](i + 1));
-            }
+            T tmp(std::move(operator[](0)));
+            shift(1, 0, ind);
+            operator[](ind) = std::move(tmp);
         } else {
             push_back(value);
-            for (size_t i = size() - 1; i + begin() > pos; i--) {
-                std::swap(operator[](i), operator[](i - 1));
-            }
+            T tmp(std::move(operator[](size() - 1)));
+            shift(ind, ind + 1, size() - 1 - ind);
+            operator[](ind) = std::move(tmp);
         }
-        return iterator(buffer, head_, tail_, capacity, pos - begin());
+        return iterator(buffer, head_, tail_, capacity, ind);
     }
 
     iterator erase(const_iterator pos) {
-        if (dist(head_, pos - begin()) + 1 < dist(pos - begin(), tail_)) {
-            for (size_t i = pos - begin(); i > 0; i--) {
-                std::swap(operator[](i), operator[](i - 1));
-            }
+        size_t ind = pos - begin();
+        if (ind < size() - ind - 1) {
+            shift(0, 1, ind);
             pop_front();
         } else {
-            for (size_t i = pos - begin(); i < size() - 1; i++) {
-                std::swap(operator[](i), operator[](i + 1));
-            }
+            shift(ind + 1, ind, size() - 1 - ind);
             pop_back();
         }
-        return iterator(buffer, head_, tail_, capacity, pos - begin());
+        return iterator(buffer, head_, tail_, capacity, ind);
     }
 
     iterator begin() {
@@ -200,14 +210,39 @@ struct circ_buff {
     }
 
 private:
-    size_t dist(size_t a, size_t b) {
-        if (b == a) {
-            return 0;
+    size_t physical(size_t ind) const {
+        return head_ + ind < capacity ? head_ + ind : ind - (capacity - head_);
+    }
+
+    // moves n elements from logical index from to logical index to, one contiguous
+    // chunk at a time: a chunk never crosses the wrap point on either side
+    void shift(size_t from, size_t to, size_t n) {
+        if (from > to) {
+            for (size_t done = 0; done < n;) {
+                size_t src = physical(from + done);
+                size_t dst = physical(to + done);
+                size_t len = std::min({n - done, capacity - src, capacity - dst});
+                move_chunk(src, dst, len);
+                done += len;
+            }
+        } else if (from < to) {
+            for (size_t left = n; left > 0;) {
+                size_t src_end = physical(from + left - 1) + 1;
+                size_t dst_end = physical(to + left - 1) + 1;
+                size_t len = std::min({left, src_end, dst_end});
+                move_chunk(src_end - len, dst_end - len, len);
+                left -= len;
+            }
         }
-        if (b > a) {
-            return b - a;
+    }
+
+    void move_chunk(size_t src, size_t dst, size_t len) {
+        if constexpr (std::is_trivially_copyable<T>::value) {
+            std::memmove(buffer + dst, buffer + src, len * sizeof(T));
+        } else if (dst < src) {
+            std::move(buffer + src, buffer + src + len, buffer + dst);
         } else {
-            return (capacity - a) + b;
+            std::move_backward(buffer + src, buffer + src + len, buffer + dst + len);
         }
     }
 
@@ -243,12 +278,13 @@ private:
             void *p = (void *) buffer;
             operator delete(p);
             buffer = new_buff;
-        } catch (const std::exception &e) {
+        } catch (...) {
             for (size_t i = 0; i < j; i++) {
                 new_buff[i].~T();
             }
             void *p = (void *) new_buff;
             operator delete(p);
+            throw;
         }
     }
 
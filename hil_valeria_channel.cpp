@@ -0,0 +1,211 @@
+#include "hil_valeria_channel.h"
+#include <counted.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    detached_task produce(channel<counted>& ch, int first, int last, bool close_after)
+    {
+        for (int i = first; i != last; ++i)
+            EXPECT_TRUE(co_await ch.send(counted(i)));
+        if (close_after)
+            ch.close();
+    }
+
+    detached_task consume(channel<counted>& ch, std::vector<int>& out)
+    {
+        while (std::optional<counted> v = co_await ch.receive())
+            out.push_back(*v);
+    }
+
+    detached_task receive_one(channel<counted>& ch, std::vector<int>& out)
+    {
+        if (std::optional<counted> v = co_await ch.receive())
+            out.push_back(*v);
+    }
+
+    detached_task send_one(channel<counted>& ch, int val, std::vector<bool>& results)
+    {
+        results.push_back(co_await ch.send(counted(val)));
+    }
+
+    detached_task send_counting(channel<counted>& ch, int n, int& sent)
+    {
+        for (int i = 0; i != n; ++i)
+        {
+            co_await ch.send(counted(i));
+            ++sent;
+        }
+    }
+
+    detached_task produce_n(channel<size_t>& ch, size_t first, size_t last, size_t step, std::atomic<size_t>& producers_left)
+    {
+        for (size_t i = first; i < last; i += step)
+            co_await ch.send(i);
+        if (--producers_left == 0)
+            ch.close();
+    }
+
+    detached_task consume_sum(channel<size_t>& ch, std::atomic<size_t>& sum, std::atomic<size_t>& consumers_left)
+    {
+        size_t local = 0;
+        while (std::optional<size_t> v = co_await ch.receive())
+            local += *v;
+        sum += local;
+        --consumers_left;
+    }
+
+    detached_task pipeline_stage(channel<size_t>& in, channel<size_t>& out)
+    {
+        while (std::optional<size_t> v = co_await in.receive())
+            co_await out.send(*v + 1);
+        out.close();
+    }
+}
+
+TEST(channel, buffered_in_order)
+{
+    counted::no_new_instances_guard g;
+    {
+        single_thread_scheduler sched;
+        channel<counted> ch(4, sched);
+        std::vector<int> out;
+        spawn(sched, produce(ch, 0, 100, true));
+        spawn(sched, consume(ch, out));
+        sched.run();
+
+        ASSERT_EQ(100u, out.size());
+        for (int i = 0; i != 100; ++i)
+            EXPECT_EQ(i, out[i]);
+        EXPECT_EQ(0u, ch.size());
+    }
+    g.expect_no_instances();
+}
+
+TEST(channel, rendezvous)
+{
+    counted::no_new_instances_guard g;
+    {
+        single_thread_scheduler sched;
+        channel<counted> ch(0, sched);
+        std::vector<int> out;
+        spawn(sched, consume(ch, out));
+        spawn(sched, produce(ch, 0, 10, true));
+        sched.run();
+
+        ASSERT_EQ(10u, out.size());
+        for (int i = 0; i != 10; ++i)
+            EXPECT_EQ(i, out[i]);
+    }
+    g.expect_no_instances();
+}
+
+TEST(channel, handoff_skips_buffer)
+{
+    single_thread_scheduler sched;
+    channel<counted> ch(4, sched);
+    std::vector<int> out;
+    std::vector<bool> sent;
+    spawn(sched, receive_one(ch, out));
+    sched.run();
+    spawn(sched, send_one(ch, 7, sent));
+    // the value went straight to the suspended receiver
+    EXPECT_EQ(0u, ch.size());
+    sched.run();
+
+    EXPECT_EQ((std::vector<bool>{true}), sent);
+    ASSERT_EQ(1u, out.size());
+    EXPECT_EQ(7, out[0]);
+}
+
+TEST(channel, sender_suspends_when_full)
+{
+    single_thread_scheduler sched;
+    channel<counted> ch(2, sched);
+    int sent = 0;
+    spawn(sched, send_counting(ch, 5, sent));
+    sched.run();
+    EXPECT_EQ(2, sent);
+    EXPECT_EQ(2u, ch.size());
+
+    std::vector<int> out;
+    spawn(sched, consume(ch, out));
+    sched.run();
+    EXPECT_EQ(5, sent);
+    EXPECT_EQ(0u, ch.size());
+    ch.close();
+    sched.run();
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3, 4}), out);
+}
+
+TEST(channel, close_wakes_everyone)
+{
+    counted::no_new_instances_guard g;
+    {
+        single_thread_scheduler sched;
+        channel<counted> full(1, sched);
+        channel<counted> empty(1, sched);
+        std::vector<bool> send_results;
+        std::vector<int> received;
+        spawn(sched, send_one(full, 1, send_results));
+        spawn(sched, send_one(full, 2, send_results));
+        for (int i = 0; i != 3; ++i)
+            spawn(sched, receive_one(empty, received));
+        sched.run();
+        EXPECT_EQ(1u, send_results.size());
+
+        full.close();
+        empty.close();
+        sched.run();
+        EXPECT_EQ((std::vector<bool>{true, false}), send_results);
+        EXPECT_TRUE(received.empty());
+
+        // buffered values survive close, new sends are refused
+        spawn(sched, send_one(full, 3, send_results));
+        spawn(sched, consume(full, received));
+        sched.run();
+        EXPECT_EQ((std::vector<bool>{true, false, false}), send_results);
+        EXPECT_EQ((std::vector<int>{1}), received);
+    }
+    g.expect_no_instances();
+}
+
+TEST(channel, thread_pool_mpmc)
+{
+    size_t const n = 100000;
+    std::atomic<size_t> sum(0), producers_left(4), consumers_left(4);
+    {
+        thread_pool_scheduler sched(4);
+        channel<size_t> ch(16, sched);
+        for (size_t c = 0; c != 4; ++c)
+            spawn(sched, consume_sum(ch, sum, consumers_left));
+        for (size_t p = 0; p != 4; ++p)
+            spawn(sched, produce_n(ch, p, n, 4, producers_left));
+        while (consumers_left != 0)
+            std::this_thread::yield();
+    }
+    EXPECT_EQ(n * (n - 1) / 2, sum);
+}
+
+TEST(channel, thread_pool_pipeline)
+{
+    size_t const n = 50000, stages = 8;
+    std::atomic<size_t> sum(0), producers_left(1), consumers_left(1);
+    {
+        thread_pool_scheduler sched(4);
+        std::vector<std::unique_ptr<channel<size_t>>> chans;
+        for (size_t i = 0; i != stages + 1; ++i)
+            chans.emplace_back(new channel<size_t>(8, sched));
+        for (size_t i = 0; i != stages; ++i)
+            spawn(sched, pipeline_stage(*chans[i], *chans[i + 1]));
+        spawn(sched, consume_sum(*chans[stages], sum, consumers_left));
+        spawn(sched, produce_n(*chans[0], 0, n, 1, producers_left));
+        while (consumers_left != 0)
+            std::this_thread::yield();
+    }
+    EXPECT_EQ(n * (n - 1) / 2 + n * stages, sum);
+}
@@ -0,0 +1,339 @@
+#ifndef HIL_VALERIA_CHANNEL_H
+#define HIL_VALERIA_CHANNEL_H
+
+// Bounded coroutine channel over circ_buff. Needs C++20 coroutines, so unlike the rest of
+// the project it is only built by targets compiled with -std=c++20.
+#if !defined(__cpp_impl_coroutine)
+#error "hil_valeria_channel.h requires C++20 coroutines"
+#endif
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "hil_valeria.h"
+
+// Something that resumes coroutine handles later, possibly on another thread.
+struct scheduler {
+    virtual void post(std::coroutine_handle<> h) = 0;
+
+    virtual ~scheduler() = default;
+};
+
+// Runs everything on the thread calling run(), for deterministic tests.
+struct single_thread_scheduler : scheduler {
+    void post(std::coroutine_handle<> h) override {
+        ready.push_back(h);
+    }
+
+    // resumes posted coroutines until none are left
+    void run() {
+        while (!ready.empty()) {
+            std::coroutine_handle<> h = ready.front();
+            ready.pop_front();
+            h.resume();
+        }
+    }
+
+private:
+    circ_buff<std::coroutine_handle<>> ready;
+};
+
+// A fixed number of worker threads sharing one queue of ready coroutines. Pending work is
+// finished before the destructor returns.
+struct thread_pool_scheduler : scheduler {
+    explicit thread_pool_scheduler(size_t threads) {
+        for (size_t i = 0; i != threads; ++i) {
+            workers.emplace_back([this] { work(); });
+        }
+    }
+
+    thread_pool_scheduler(thread_pool_scheduler const &) = delete;
+
+    thread_pool_scheduler &operator=(thread_pool_scheduler const &) = delete;
+
+    ~thread_pool_scheduler() override {
+        {
+            std::lock_guard<std::mutex> lg(m);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (std::thread &t : workers) {
+            t.join();
+        }
+    }
+
+    void post(std::coroutine_handle<> h) override {
+        {
+            std::lock_guard<std::mutex> lg(m);
+            ready.push_back(h);
+        }
+        cv.notify_one();
+    }
+
+private:
+    void work() {
+        std::unique_lock<std::mutex> lock(m);
+        for (;;) {
+            cv.wait(lock, [this] { return stopping || !ready.empty(); });
+            if (ready.empty()) {
+                return;
+            }
+            std::coroutine_handle<> h = ready.front();
+            ready.pop_front();
+            lock.unlock();
+            h.resume();
+            lock.lock();
+        }
+    }
+
+    std::mutex m;
+    std::condition_variable cv;
+    bool stopping = false;
+    circ_buff<std::coroutine_handle<>> ready;
+    std::vector<std::thread> workers;
+};
+
+// Fire-and-forget coroutine, started by spawn() and destroyed when it finishes.
+struct detached_task {
+    struct promise_type {
+        detached_task get_return_object() {
+            return {std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+
+        void return_void() {}
+
+        void unhandled_exception() {
+            std::terminate();
+        }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+inline void spawn(scheduler &sched, detached_task task) {
+    sched.post(task.handle);
+}
+
+// Bounded multi-producer multi-consumer channel: co_await send(v) suspends while capacity
+// values are buffered, co_await receive() suspends while there are none. A value sent to a
+// waiting receiver goes straight into that receiver's awaiter, bypassing the buffer, and
+// capacity 0 makes every send such a rendezvous. Suspended coroutines are resumed through
+// the scheduler, so no thread ever blocks inside the channel; the lock only guards O(1)
+// bookkeeping.
+//
+// After close() sends return false, receive drains what is buffered and then yields nullopt.
+template<typename T>
+struct channel {
+    struct send_awaiter;
+    struct receive_awaiter;
+
+    channel(size_t capacity, scheduler &sched) : capacity(capacity), sched(sched) {}
+
+    channel(channel const &) = delete;
+
+    channel &operator=(channel const &) = delete;
+
+    // co_await yields false if the channel was closed and the value was not delivered
+    send_awaiter send(T value) {
+        return send_awaiter(*this, std::move(value));
+    }
+
+    // co_await yields nullopt once the channel is closed and drained
+    receive_awaiter receive() {
+        return receive_awaiter(*this);
+    }
+
+    void close() {
+        send_awaiter *senders;
+        receive_awaiter *receivers;
+        {
+            std::lock_guard<spin_lock> lg(lock);
+            closed = true;
+            senders = waiting_senders.take_all();
+            receivers = waiting_receivers.take_all();
+        }
+        while (senders != nullptr) {
+            send_awaiter *next = senders->next;
+            senders->delivered = false;
+            sched.post(senders->handle);
+            senders = next;
+        }
+        while (receivers != nullptr) {
+            receive_awaiter *next = receivers->next;
+            sched.post(receivers->handle);
+            receivers = next;
+        }
+    }
+
+    // number of buffered values, suspended senders not included
+    size_t size() const {
+        std::lock_guard<spin_lock> lg(lock);
+        return buffer.size();
+    }
+
+    struct send_awaiter {
+        send_awaiter(channel &ch, T &&value) : ch(ch), value(std::move(value)) {}
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        bool await_suspend(std::coroutine_handle<> h) {
+            std::unique_lock<spin_lock> lg(ch.lock);
+            if (ch.closed) {
+                delivered = false;
+                return false;
+            }
+            if (receive_awaiter *r = ch.waiting_receivers.pop()) {
+                r->value.emplace(std::move(value));
+                lg.unlock();
+                ch.sched.post(r->handle);
+                return false;
+            }
+            if (ch.buffer.size() < ch.capacity) {
+                ch.buffer.push_back(value);
+                return false;
+            }
+            handle = h;
+            ch.waiting_senders.push(this);
+            // may be resumed on another thread as soon as the lock is released
+            return true;
+        }
+
+        bool await_resume() const noexcept {
+            return delivered;
+        }
+
+    private:
+        friend struct channel;
+
+        channel &ch;
+        T value;
+        bool delivered = true;
+        std::coroutine_handle<> handle;
+        send_awaiter *next = nullptr;
+    };
+
+    struct receive_awaiter {
+        explicit receive_awaiter(channel &ch) : ch(ch) {}
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        bool await_suspend(std::coroutine_handle<> h) {
+            std::unique_lock<spin_lock> lg(ch.lock);
+            if (!ch.buffer.empty()) {
+                value.emplace(std::move(ch.buffer.front()));
+                ch.buffer.pop_front();
+                // the oldest suspended sender takes the freed slot
+                if (send_awaiter *s = ch.waiting_senders.pop()) {
+                    ch.buffer.push_back(s->value);
+                    lg.unlock();
+                    ch.sched.post(s->handle);
+                }
+                return false;
+            }
+            if (send_awaiter *s = ch.waiting_senders.pop()) {
+                value.emplace(std::move(s->value));
+                lg.unlock();
+                ch.sched.post(s->handle);
+                return false;
+            }
+            if (ch.closed) {
+                return false;
+            }
+            handle = h;
+            ch.waiting_receivers.push(this);
+            return true;
+        }
+
+        std::optional<T> await_resume() {
+            return std::move(value);
+        }
+
+    private:
+        friend struct channel;
+
+        channel &ch;
+        std::optional<T> value;
+        std::coroutine_handle<> handle;
+        receive_awaiter *next = nullptr;
+    };
+
+private:
+    struct spin_lock {
+        void lock() {
+            while (flag.test_and_set(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+        }
+
+        void unlock() {
+            flag.clear(std::memory_order_release);
+        }
+
+    private:
+        std::atomic_flag flag = ATOMIC_FLAG_INIT;
+    };
+
+    // intrusive FIFO of suspended awaiters, linked through their next pointers
+    template<typename A>
+    struct waiter_list {
+        void push(A *a) {
+            a->next = nullptr;
+            if (tail == nullptr) {
+                head = a;
+            } else {
+                tail->next = a;
+            }
+            tail = a;
+        }
+
+        A *pop() {
+            A *a = head;
+            if (a != nullptr) {
+                head = a->next;
+                if (head == nullptr) {
+                    tail = nullptr;
+                }
+            }
+            return a;
+        }
+
+        A *take_all() {
+            A *a = head;
+            head = tail = nullptr;
+            return a;
+        }
+
+    private:
+        A *head = nullptr;
+        A *tail = nullptr;
+    };
+
+    size_t capacity;
+    scheduler &sched;
+    mutable spin_lock lock;
+    bool closed = false;
+    circ_buff<T> buffer;
+    waiter_list<send_awaiter> waiting_senders;
+    waiter_list<receive_awaiter> waiting_receivers;
+};
+
+#endif //HIL_VALERIA_CHANNEL_H
@@ -3,3 +3,70 @@
 using container = circular_buffer<counted>;
 
 #include "tests.inl"
+
+TEST(sliding_window, min_max_sum)
+{
+    counted::no_new_instances_guard g;
+
+    sliding_window<counted, int> w(3);
+    for (int v : {5, 1, 4, 2, 8})
+        w.push_back(v);
+
+    sliding_window<counted, int> const& cw = w;
+    EXPECT_EQ(3u, cw.size());
+    EXPECT_EQ(4, cw.front());
+    EXPECT_EQ(8, cw.back());
+    EXPECT_EQ(2, cw.min());
+    EXPECT_EQ(8, cw.max());
+    EXPECT_EQ(14, cw.sum());
+}
+
+TEST(sliding_window, full_window_does_not_allocate)
+{
+    sliding_window<int> w(100);
+    for (int i = 0; i != 100; ++i)
+        w.push_back(i);
+
+    allocation_arena arena;
+    for (int i = 100; i != 1000; ++i)
+        w.push_back(i % 7 == 0 ? -i : i);
+    EXPECT_EQ(0u, arena.allocations());
+    EXPECT_EQ(-994, w.min());
+    EXPECT_EQ(999, w.max());
+}
+
+TEST(sliding_window, fault_injection_push_back_full)
+{
+    faulty_run([]
+    {
+        sliding_window<counted, int> w(3);
+        {
+            fault_injection_disable dg;
+            for (int v : {5, 1, 4})
+                w.push_back(v);
+        }
+
+        try
+        {
+            w.push_back(7);
+        }
+        catch (...)
+        {
+            fault_injection_disable dg;
+            EXPECT_EQ(3u, w.size());
+            EXPECT_EQ(5, w.front());
+            EXPECT_EQ(4, w.back());
+            EXPECT_EQ(1, w.min());
+            EXPECT_EQ(5, w.max());
+            EXPECT_EQ(10, w.sum());
+            throw;
+        }
+
+        fault_injection_disable dg;
+        EXPECT_EQ(3u, w.size());
+        EXPECT_EQ(1, w.front());
+        EXPECT_EQ(1, w.min());
+        EXPECT_EQ(7, w.max());
+        EXPECT_EQ(12, w.sum());
+    });
+}
@@ -1,6 +1,8 @@
 #include <algorithm>
 #include <iterator>
 
+#include "ring_spans.h"
+
 template<typename S>
 class circular_buffer;
 
@@ -22,65 +24,91 @@ public:
     typedef std::bidirectional_iterator_tag iterator_category;
 
 private:
-    S *data;
-    size_t ind, left, capacity;
+    // the current element and the bounds of the storage, so walking only compares pointers;
+    // head (the first element) turns positions back into indices for the random-access operations
+    S *ptr, *extreme_left, *extreme_right, *head;
+
+    iterator1(S *data, size_t ind, size_t left, size_t capacity)
+            : ptr(data), extreme_left(data), extreme_right(data + capacity), head(data + left) {
+        if (capacity != 0) {
+            ptr = data + (left + ind) % capacity;
+        }
+    }
 
-    iterator1(S *data, size_t ind, size_t left, size_t capacity) : data(data), ind(ind),
-                                                                   left(left), capacity(capacity) {}
+    difference_type index() const {
+        difference_type capacity = extreme_right - extreme_left;
+        difference_type ind = ptr - head;
+        return ind < 0 ? ind + capacity : ind;
+    }
+
+    iterator1 at(difference_type ind) const {
+        iterator1 res = *this;
+        difference_type capacity = extreme_right - extreme_left;
+        if (capacity != 0) {
+            difference_type pos = (head - extreme_left + ind) % capacity;
+            res.ptr = extreme_left + (pos < 0 ? pos + capacity : pos);
+        }
+        return res;
+    }
 
 public:
-    template<typename = std::enable_if_t<std::is_const<S>::value>>
-    iterator1(const iterator1<std::decay_t<S>> &other) {
-        data = other.data;
-        ind = other.ind;
-        left = other.left;
-        capacity = other.capacity;
+    template<typename U, typename = std::enable_if_t<std::is_same<const U, S>::value>>
+    iterator1(const iterator1<U> &other) {
+        ptr = other.ptr;
+        extreme_left = other.extreme_left;
+        extreme_right = other.extreme_right;
+        head = other.head;
     }
 
     reference operator*() const {
-        return *(data + ((left + ind) % capacity));
+        return *ptr;
     }
 
     pointer operator->() const {
-        return (data + ((left + ind) % capacity));
+        return ptr;
     }
 
     iterator1 &operator++() {
-        ++ind;
+        if (++ptr == extreme_right) {
+            ptr = extreme_left;
+        }
         return *this;
     }
 
     iterator1 &operator--() {
-        --ind;
+        if (ptr == extreme_left) {
+            ptr = extreme_right;
+        }
+        --ptr;
         return *this;
     }
 
     iterator1 operator++(int) {
         iterator1 cur = *this;
-        ++ind;
+        ++*this;
         return cur;
     }
 
     iterator1 operator--(int) {
         iterator1 cur = *this;
-        --ind;
+        --*this;
         return cur;
     }
 
     friend iterator1 operator+(iterator1 const &oth, difference_type add) {
-        return iterator1(oth.data, oth.ind + add, oth.left, oth.capacity);
+        return oth.at(oth.index() + add);
     }
 
     friend iterator1 operator+(difference_type add, iterator1 const &oth) {
-        return iterator1(oth.data, oth.ind + add, oth.left, oth.capacity);
+        return oth.at(oth.index() + add);
     }
 
     friend iterator1 operator-(iterator1 const &oth, difference_type add) {
-        return iterator1(oth.data, oth.ind - add, oth.left, oth.capacity);
+        return oth.at(oth.index() - add);
     }
 
     friend iterator1 operator-(difference_type add, iterator1 const &oth) {
-        return iterator1(oth.data, oth.ind - add, oth.left, oth.capacity);
+        return oth.at(oth.index() - add);
     }
 
     friend iterator1 operator+=(iterator1 &oth, difference_type add) {
@@ -94,7 +122,7 @@ public:
     }
 
     friend difference_type operator-(iterator1 const &first, iterator1 const &second) {
-        return first.ind - second.ind;
+        return first.index() - second.index();
     }
 
     template<typename U, typename I>
@@ -104,7 +132,7 @@ public:
     friend bool operator!=(iterator1<U> first, iterator1<I> second);
 
     bool operator<(iterator1 second) const {
-        return ind < second.ind;
+        return index() < second.index();
     }
 
     bool operator<=(iterator1 second) const {
@@ -127,8 +155,9 @@ class circular_buffer {
     T *data;
 
     void ensure_capacity(size_t size) {
+        // size < capacity afterwards, so begin() == end() only when empty
         if (size >= capacity) {
-            circular_buffer<T> oth(capacity * 2 + 1);
+            circular_buffer<T> oth(capacity * 2 + 2);
             for (size_t i = 0, temp = left; i < size_; ++i, temp = (temp + 1) % capacity) {
                 oth.push_back(data[temp]);
             }
@@ -178,6 +207,14 @@ public:
         return size_;
     }
 
+    ring_spans<T> as_spans() {
+        return make_ring_spans(data, capacity, left, size_);
+    }
+
+    ring_spans<const T> as_spans() const {
+        return make_ring_spans<const T>(data, capacity, left, size_);
+    }
+
     bool empty() {
         return size_ == 0;
     }
@@ -276,7 +313,7 @@ public:
     }
 
     iterator erase(const_iterator pos) {
-        size_t ind = pos.ind;
+        size_t ind = pos.index();
         iterator cur = iterator(data, ind, left, capacity);
         if (2 * ind <= size_) {
             while (cur != begin()) {
@@ -295,7 +332,7 @@ public:
     }
 
     iterator insert(const_iterator pos, const T &dat) {
-        size_t ind = pos.ind;
+        size_t ind = pos.index();
         if (2 * ind <= size_) {
             push_front(dat);
             iterator temp = iterator(data, ind, left, capacity), cur = begin();
@@ -331,11 +368,159 @@ void swap(circular_buffer<T> &first, circular_buffer<T> &second) {
 
 template<typename U, typename I>
 bool operator==(iterator1<U> first, iterator1<I> second) {
-    return first.data == second.data && first.ind == second.ind
-           && first.left == second.left && first.capacity == second.capacity;
+    return first.ptr == second.ptr && first.head == second.head;
 }
 
 template<typename U, typename I>
 bool operator!=(iterator1<U> first, iterator1<I> second) {
     return !(first == second);
 }
+
+// Rolling min, max and sum of a FIFO window of samples, all O(1) amortized.
+// Besides the samples themselves two monotonic queues of sample numbers are kept: mins holds the
+// samples that can still become the minimum (increasing values, the newest of equal ones), maxs
+// likewise for the maximum, so the answer is always at their front.
+// A window constructed with a capacity allocates everything up front and never again: pushing into
+// a full window drops its oldest sample, but only once the new one is in, so a push_back that throws
+// leaves the window as it was. A default constructed one grows and is trimmed by pop_front().
+// Sum is kept by adding and subtracting samples, so choose Sum wide enough for capacity samples.
+template<typename T, typename Sum = T>
+class sliding_window {
+    circular_buffer<T> values;
+    circular_buffer<size_t> mins, maxs;
+    size_t pushed, popped, capacity;
+    Sum total;
+
+    T &sample(size_t number) {
+        return values[number - popped];
+    }
+
+    const T &sample(size_t number) const {
+        return values[number - popped];
+    }
+
+    // how many samples at the back of q the newest sample dominates, before it is pushed to q
+    template<typename Dominated>
+    size_t dominated_count(circular_buffer<size_t> &q, Dominated dominated) {
+        size_t n = 0;
+        while (n != q.size() && dominated(sample(q[q.size() - 1 - n]))) {
+            ++n;
+        }
+        return n;
+    }
+
+    // drops that many samples from behind the one just pushed to q; the freed room keeps the re-push from allocating
+    static void trim_back(circular_buffer<size_t> &q, size_t dropped) {
+        size_t number = q.back();
+        q.pop_back();
+        for (; dropped != 0; --dropped) {
+            q.pop_back();
+        }
+        q.push_back(number);
+    }
+
+public:
+    sliding_window() : pushed(0), popped(0), capacity(0), total() {}
+
+    // room for capacity + 1 samples (circular_buffer keeps one slot free), the extra one holds the newest
+    // sample of a full window until the oldest is dropped
+    explicit sliding_window(size_t capacity) : values(capacity + 2), mins(capacity + 2), maxs(capacity + 2),
+                                               pushed(0), popped(0), capacity(capacity), total() {}
+
+    size_t size() const {
+        return pushed - popped;
+    }
+
+    bool empty() const {
+        return pushed == popped;
+    }
+
+    // 0 for a growable window
+    size_t max_size() const {
+        return capacity;
+    }
+
+    void push_back(const T &value) {
+        bool full = capacity != 0 && size() == capacity;
+        values.push_back(value);
+        size_t mins_dropped, maxs_dropped;
+        try {
+            // comparisons may throw as well, so they all run before anything is dropped
+            const T &v = values.back();
+            mins_dropped = dominated_count(mins, [&v](const T &x) { return !(x < v); });
+            maxs_dropped = dominated_count(maxs, [&v](const T &x) { return !(v < x); });
+            mins.push_back(pushed);
+            try {
+                maxs.push_back(pushed);
+            } catch (...) {
+                mins.pop_back();
+                throw;
+            }
+        } catch (...) {
+            values.pop_back();
+            throw;
+        }
+        trim_back(mins, mins_dropped);
+        trim_back(maxs, maxs_dropped);
+        if (full) {
+            pop_front();
+        }
+        total += values.back();
+        ++pushed;
+    }
+
+    void pop_front() {
+        if (mins.front() == popped) {
+            mins.pop_front();
+        }
+        if (maxs.front() == popped) {
+            maxs.pop_front();
+        }
+        total -= values.front();
+        values.pop_front();
+        ++popped;
+    }
+
+    void clear() {
+        while (!empty()) {
+            pop_front();
+        }
+        total = Sum();
+    }
+
+    T &front() {
+        return values.front();
+    }
+
+    T &back() {
+        return values.back();
+    }
+
+    const T &front() const {
+        return values.front();
+    }
+
+    const T &back() const {
+        return values.back();
+    }
+
+    T &min() {
+        return sample(mins.front());
+    }
+
+    T &max() {
+        return sample(maxs.front());
+    }
+
+    const T &min() const {
+        return sample(mins.front());
+    }
+
+    const T &max() const {
+        return sample(maxs.front());
+    }
+
+    Sum sum() const {
+        return total;
+    }
+};
@@ -3,3 +3,49 @@
 using container = circular_buffer<counted>;
 
 #include "tests.inl"
+
+static_assert(sizeof(circular_buffer<int>) == sizeof(int*) + 3 * sizeof(size_t), "no_stats must take no space");
+
+TEST(stats, growth)
+{
+    counted::no_new_instances_guard g;
+
+    circular_buffer<counted, growth_stats> c;
+    EXPECT_EQ(0u, c.stats().capacity);
+    for (int i = 0; i != 100; ++i)
+        c.push_back(i);
+
+    growth_stats const& s = c.stats();
+    EXPECT_EQ(160u, s.capacity);
+    EXPECT_EQ(4u, s.reallocations);
+    EXPECT_EQ(100u, s.high_water_mark);
+    EXPECT_LT(0u, s.bytes_copied);
+}
+
+TEST(stats, wraparounds_and_shifts)
+{
+    counted::no_new_instances_guard g;
+
+    circular_buffer<counted, growth_stats> c;
+    mass_push_back(c, {1, 2, 3, 4, 5, 6});
+    c.push_front(0);
+    EXPECT_EQ(1u, c.stats().wraparounds);
+
+    c.insert(c.begin() + 2, 10);
+    c.erase(c.end() - 2);
+    expect_eq(c, {0, 1, 10, 2, 3, 4, 6});
+    EXPECT_EQ(2u, c.stats().shifts);
+    EXPECT_EQ(3u, c.stats().shifted_elements);
+    EXPECT_EQ(2u, c.stats().max_shift);
+}
+
+TEST(stats, swap)
+{
+    circular_buffer<int, growth_stats> c1, c2;
+    for (int i = 0; i != 20; ++i)
+        c1.push_back(i);
+    swap(c1, c2);
+    EXPECT_EQ(0u, c1.stats().high_water_mark);
+    EXPECT_EQ(20u, c2.stats().high_water_mark);
+    EXPECT_EQ(20u, c2.size());
+}
@@ -3,14 +3,53 @@
 #include <memory>
 #include <iterator>
 #include <type_traits>
+#include "ring_spans.h"
 constexpr int INIT_SIZE = 10;
-template<typename T>
+// Statistics policies of circular_buffer. The buffer holds its policy, calls the hooks below and exposes
+// it through stats(); no_stats is empty and its hooks are no-ops, so a buffer without statistics costs nothing extra.
+struct no_stats
+{
+	void on_grow(size_t, size_t, size_t) noexcept {}
+	void on_wrap() noexcept {}
+	void on_size(size_t) noexcept {}
+	void on_shift(size_t) noexcept {}
+};
+struct growth_stats
+{
+	size_t capacity = 0;
+	size_t reallocations = 0;
+	size_t bytes_copied = 0;
+	size_t wraparounds = 0;
+	size_t high_water_mark = 0;
+	size_t shifts = 0;
+	size_t shifted_elements = 0;
+	size_t max_shift = 0;
+	void on_grow(size_t old_capacity, size_t new_capacity, size_t bytes) noexcept
+	{
+		if (old_capacity != 0) { reallocations++; }
+		capacity = new_capacity;
+		bytes_copied += bytes;
+	}
+	void on_wrap() noexcept { wraparounds++; }
+	void on_size(size_t size) noexcept
+	{
+		if (size > high_water_mark) { high_water_mark = size; }
+	}
+	// elements moved by one insert or erase
+	void on_shift(size_t distance) noexcept
+	{
+		shifts++;
+		shifted_elements += distance;
+		if (distance > max_shift) { max_shift = distance; }
+	}
+};
+template<typename T, typename Stats = no_stats>
 struct circular_buffer;
-template<typename T>
-void swap(circular_buffer<T> &b1, circular_buffer<T> &b2) noexcept;
+template<typename T, typename Stats>
+void swap(circular_buffer<T, Stats> &b1, circular_buffer<T, Stats> &b2) noexcept;
 template <typename U>
 struct circular_iterator;
-template <typename T>
+template <typename T, typename Stats>
 struct circular_buffer
 {
 public:
@@ -18,7 +57,7 @@ public:
 	using const_iterator = circular_iterator<const T>;
 	using reverse_iterator = std::reverse_iterator<iterator>;
 	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
-	circular_buffer() : buffer(nullptr), capacity(0), head(0), tail(0){}
+	circular_buffer() : store{}, capacity(0), head(0), tail(0){}
 	circular_buffer(circular_buffer const &other): circular_buffer()
 	{
 		if (!other.empty())
@@ -34,11 +73,8 @@ public:
 	}
 	~circular_buffer()
 	{
-		if (!empty())
-		{
-			for (const_iterator it = begin(); it != end(); it++) { (*it).~T(); }
-			operator delete(buffer);
-		}
+		for (const_iterator it = begin(); it != end(); it++) { (*it).~T(); }
+		operator delete(store.buffer);
 	}
 	size_t size() const
 	{
@@ -54,9 +90,11 @@ public:
 	void push_back(T const &elem)
 	{
 		ensure_capacity();
-		new (&buffer[tail]) T(elem);
+		new (&store.buffer[tail]) T(elem);
 		tail++;
 		tail %= capacity;
+		if (tail == 0) { policy().on_wrap(); }
+		policy().on_size(size());
 	}
 	void push_front(T const &elem)
 	{
@@ -64,9 +102,12 @@ public:
 		size_t head2 = head;
 		if (head2 == 0) { head2 = capacity - 1; }
 		else { head2--; }
-		new(&buffer[head2]) T(elem);
+		new(&store.buffer[head2]) T(elem);
+		if (head == 0) { policy().on_wrap(); }
 		head = head2;
+		policy().on_size(size());
 	}
+	Stats const& stats() const noexcept { return store; }
 	void clear()
 	{
 		for (const_iterator it = begin(); it != end(); it++) { (*it).~T(); }
@@ -77,24 +118,26 @@ public:
 	{
 		return size() == 0;
 	}
+	ring_spans<T> as_spans() { return make_ring_spans(store.buffer, capacity, head, size()); }
+	ring_spans<const T> as_spans() const { return make_ring_spans<const T>(store.buffer, capacity, head, size()); }
 	T& operator[](const size_t index)
 	{
-		if (head < tail || capacity - head > index) { return buffer[head + index]; }
-		else { return buffer[index - (capacity - head)]; }
+		if (head < tail || capacity - head > index) { return store.buffer[head + index]; }
+		else { return store.buffer[index - (capacity - head)]; }
 	}
 	T& operator[](const size_t index) const
 	{
-		if (head < tail || capacity - head >= index) { return buffer[head + index]; }
-		else { return buffer[index - (capacity - head)]; }
+		if (head < tail || capacity - head > index) { return store.buffer[head + index]; }
+		else { return store.buffer[index - (capacity - head)]; }
 	}
 	T& front() { return operator[](0); }
 	T& back() { return operator[](size() - 1); }
 	T& front() const { return operator[](0); }
 	T& back() const { return operator[](size() - 1); }
-	iterator begin() { return iterator(buffer, 0, head, tail, capacity); } const
-	iterator end() { return iterator(buffer, size(), head, tail, capacity); } const
-	const_iterator begin() const { return const_iterator(buffer, 0, head, tail, capacity); } const
-	const_iterator end() const { return const_iterator(buffer, size(), head, tail, capacity); } const
+	iterator begin() { return iterator(store.buffer, 0, head, tail, capacity); } const
+	iterator end() { return iterator(store.buffer, size(), head, tail, capacity); } const
+	const_iterator begin() const { return const_iterator(store.buffer, 0, head, tail, capacity); } const
+	const_iterator end() const { return const_iterator(store.buffer, size(), head, tail, capacity); } const
 	reverse_iterator rbegin() { return reverse_iterator(end()); } const
 	reverse_iterator rend() { return reverse_iterator(begin()); } const
 	const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); } const
@@ -102,56 +145,68 @@ public:
 	iterator insert(const_iterator pos, T const &value)
 	{
 		//ensure_capacity();
-		if (dist(head, pos.index) + 1 <= dist(pos.index, tail))
+		// pos.index counts from the front, so it is the number of elements before pos
+		if (pos.index + 1 <= size() - pos.index)
 		{
 			push_front(value);
 			for (int i = 0; i < pos - const_iterator(begin()); i++) { std::swap(operator[](i), operator[](i + 1)); }
+			policy().on_shift(pos - const_iterator(begin()));
 		}
 		else
 		{
 			push_back(value);
 			for (int i = size() - 1; i > pos - const_iterator(begin()); i--) { std::swap(operator[](i), operator[](i - 1)); }
+			policy().on_shift(size() - 1 - (pos - const_iterator(begin())));
 		}
-		return iterator(buffer, pos - const_iterator(begin()), head, tail, capacity);
+		return iterator(store.buffer, pos - const_iterator(begin()), head, tail, capacity);
 	}
 	void pop_front()
 	{
-		buffer[head].~T();
+		store.buffer[head].~T();
 		head++;
 		head %= capacity;
+		if (head == 0) { policy().on_wrap(); }
 	}
 	void pop_back()
 	{
-		if(tail == 0) { tail = capacity - 1; }
+		if (tail == 0)
+		{
+			tail = capacity;
+			policy().on_wrap();
+		}
 		tail--;
-		buffer[tail].~T();
+		store.buffer[tail].~T();
 	}
 	iterator erase(const_iterator pos)
 	{
-		if (dist(head, pos.index) <= dist(pos.index, tail) - 1)
+		if (pos.index <= size() - 1 - pos.index)
 		{
 			for (size_t i = pos - const_iterator(begin()); i > 0; i--) { std::swap(operator[](i), operator[](i - 1)); }
+			policy().on_shift(pos - const_iterator(begin()));
 			pop_front();
 		}
 		else
 		{
 			for (size_t i = pos - const_iterator(begin()); i < size() - 1; i++) { std::swap(operator[](i), operator[](i + 1)); }
+			policy().on_shift(size() - 1 - (pos - const_iterator(begin())));
 			pop_back();
 		}
-		return iterator(buffer, pos - const_iterator(begin()), head, tail, capacity);
+		return iterator(store.buffer, pos - const_iterator(begin()), head, tail, capacity);
 	}
-	template <typename X>
-	friend void swap(circular_buffer<X> &b1, circular_buffer<X> &b2) noexcept;
+	template <typename X, typename S>
+	friend void swap(circular_buffer<X, S> &b1, circular_buffer<X, S> &b2) noexcept;
 	friend iterator;
 	friend const_iterator;
 private:
+	Stats& policy() noexcept { return store; }
 	void ensure_capacity()
 	{
 		if (capacity == 0)
 		{
-			buffer = static_cast<T*>(operator new(sizeof(T) * INIT_SIZE));
+			store.buffer = static_cast<T*>(operator new(sizeof(T) * INIT_SIZE));
 			capacity = INIT_SIZE;
 			head = tail = 0;
+			policy().on_grow(0, capacity, 0);
 		}
 		else
 			if (size() == capacity - 1)
@@ -166,10 +221,11 @@ private:
 						j++;
 					}
 					for (iterator it = begin(); it != end(); it++) (*it).~T();
+					policy().on_grow(capacity, 2 * capacity, sizeof(T) * size());
 					tail = size();
 					head = 0;
-					operator delete(buffer);
-					buffer = new_buffer;
+					operator delete(store.buffer);
+					store.buffer = new_buffer;
 					capacity *= 2;
 				}
 				catch (std::runtime_error &e)
@@ -179,18 +235,19 @@ private:
 				}
 			}
 	}
-	size_t dist(size_t one, size_t two)
+	// the policy is the (usually empty) base of the buffer pointer: no_stats takes no space, and the
+	// policy's members stay apart from the buffer's own, growth_stats has a capacity as well
+	struct storage : Stats
 	{
-		if (head < tail || one <= two) { return two - one; }
-		else { return capacity - one + two; }
-	}
-	T *buffer;
+		T *buffer;
+	};
+	storage store;
 	size_t capacity, head, tail;
 };
-template<typename X>
-void swap(circular_buffer<X> &b1, circular_buffer<X> &b2) noexcept
+template<typename X, typename S>
+void swap(circular_buffer<X, S> &b1, circular_buffer<X, S> &b2) noexcept
 {
-	std::swap(b1.buffer, b2.buffer);
+	std::swap(b1.store, b2.store);
 	std::swap(b1.capacity, b2.capacity);
 	std::swap(b1.head, b2.head);
 	std::swap(b1.tail, b2.tail);
@@ -254,8 +311,8 @@ struct circular_iterator
 	{
 		return index - other.index;
 	}*/
-	friend circular_buffer<U>;
-	friend circular_buffer<typename std::remove_const_t<U>>;
+	template <typename X, typename S>
+	friend struct circular_buffer;
 	friend circular_iterator<const U>;
 	template <typename T>
 	friend circular_iterator<T> operator+(circular_iterator<T> it, ptrdiff_t n);
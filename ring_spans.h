@@ -0,0 +1,124 @@
+#ifndef RING_SPANS_H
+#define RING_SPANS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+// A contiguous run of elements inside a ring buffer (a minimal std::span, the project is C++17).
+template <typename T>
+struct contiguous_span {
+    T *ptr;
+    size_t len;
+
+    T *data() const {
+        return ptr;
+    }
+
+    size_t size() const {
+        return len;
+    }
+
+    bool empty() const {
+        return len == 0;
+    }
+
+    T *begin() const {
+        return ptr;
+    }
+
+    T *end() const {
+        return ptr + len;
+    }
+
+    T &operator[](size_t ind) const {
+        return ptr[ind];
+    }
+};
+
+// The contents of a ring buffer in order: array_one and then array_two,
+// array_two is empty unless the contents wrap around the end of the storage.
+template <typename T>
+struct ring_spans {
+    contiguous_span<T> array_one;
+    contiguous_span<T> array_two;
+
+    size_t size() const {
+        return array_one.size() + array_two.size();
+    }
+};
+
+// size elements starting at index first of a ring of the given capacity
+template <typename T>
+ring_spans<T> make_ring_spans(T *data, size_t capacity, size_t first, size_t size) {
+    if (size == 0) {
+        return {{data, 0}, {data, 0}};
+    }
+    size_t len = std::min(size, capacity - first);
+    return {{data + first, len}, {data, size - len}};
+}
+
+// Whole-container algorithms that walk the (at most two) contiguous segments of containers
+// providing as_spans() and fall back to begin()/end() for everything else.
+// These are separate entry points rather than fast paths inside std::copy/std::for_each: overloads
+// may not be added to namespace std, and C++17 gives the standard algorithms no hook that a
+// segmented iterator could use. Dispatching on the container also keeps the iterators as they are.
+namespace segmented {
+    template <typename C, typename = void>
+    struct has_spans : std::false_type {};
+
+    template <typename C>
+    struct has_spans<C, std::void_t<decltype(std::declval<C &>().as_spans())>> : std::true_type {};
+
+    // f(first, last) for every contiguous segment, or once for the whole iterator range
+    template <typename C, typename F>
+    void for_each_segment(C &c, F f) {
+        if constexpr (has_spans<C>::value) {
+            auto spans = c.as_spans();
+            f(spans.array_one.begin(), spans.array_one.end());
+            if (!spans.array_two.empty()) {
+                f(spans.array_two.begin(), spans.array_two.end());
+            }
+        } else {
+            f(c.begin(), c.end());
+        }
+    }
+
+    template <typename C, typename OutputIt>
+    OutputIt copy(C &c, OutputIt out) {
+        for_each_segment(c, [&out](auto first, auto last) {
+            if constexpr (std::is_pointer<decltype(first)>::value) {
+                out = std::copy(first, last, out);
+            } else {
+                // iterators of the fallback path are not required to be fully conforming
+                for (; first != last; ++first, ++out) {
+                    *out = *first;
+                }
+            }
+        });
+        return out;
+    }
+
+    template <typename C, typename F>
+    F for_each(C &c, F f) {
+        for_each_segment(c, [&f](auto first, auto last) {
+            for (; first != last; ++first) {
+                f(*first);
+            }
+        });
+        return f;
+    }
+
+    template <typename C, typename V>
+    V accumulate(C &c, V init) {
+        for_each_segment(c, [&init](auto first, auto last) {
+            for (; first != last; ++first) {
+                init = std::move(init) + *first;
+            }
+        });
+        return init;
+    }
+}
+
+#endif //RING_SPANS_H
@@ -3,3 +3,284 @@
 using container = my_deq<counted>;
 
 #include "tests.inl"
+
+namespace
+{
+    my_deq<counted>::shrink_policy disabled_shrink_policy()
+    {
+        my_deq<counted>::shrink_policy policy;
+        policy.enabled = false;
+        return policy;
+    }
+
+    void push_pop(my_deq<counted>& c, int n)
+    {
+        for (int i = 0; i != n; ++i)
+            c.push_back(i);
+        while (c.size() > 1)
+            c.pop_front();
+    }
+}
+
+TEST(shrink, enabled_by_default)
+{
+    counted::no_new_instances_guard g;
+
+    container c;
+    EXPECT_TRUE(c.get_shrink_policy().enabled);
+    push_pop(c, 1000);
+    EXPECT_LT(0u, c.get_shrink_stats().shrinks);
+    expect_eq(c, {999});
+}
+
+TEST(shrink, opt_out)
+{
+    counted::no_new_instances_guard g;
+
+    container c;
+    c.set_shrink_policy(disabled_shrink_policy());
+    EXPECT_FALSE(c.get_shrink_policy().enabled);
+    push_pop(c, 1000);
+    EXPECT_EQ(0u, c.get_shrink_stats().shrinks);
+    expect_eq(c, {999});
+}
+
+TEST(shrink, after_pops)
+{
+    counted::no_new_instances_guard g;
+
+    container c;
+    for (int i = 0; i != 1000; ++i)
+        c.push_back(i);
+    for (int i = 0; i != 990; ++i)
+    {
+        if (i % 2 == 0)
+            c.pop_front();
+        else
+            c.pop_back();
+    }
+    EXPECT_LT(0u, c.get_shrink_stats().shrinks);
+    EXPECT_EQ(0u, c.get_shrink_stats().failed_shrinks);
+    expect_eq(c, {495, 496, 497, 498, 499, 500, 501, 502, 503, 504});
+}
+
+TEST(shrink, policy_is_copied)
+{
+    counted::no_new_instances_guard g;
+
+    container c;
+    c.set_shrink_policy(disabled_shrink_policy());
+
+    container copy(c);
+    EXPECT_FALSE(copy.get_shrink_policy().enabled);
+
+    container assigned;
+    assigned = c;
+    EXPECT_FALSE(assigned.get_shrink_policy().enabled);
+    push_pop(assigned, 1000);
+    EXPECT_EQ(0u, assigned.get_shrink_stats().shrinks);
+
+    c = container();
+    EXPECT_TRUE(c.get_shrink_policy().enabled);
+}
+
+TEST(shrink, policy_is_swapped)
+{
+    counted::no_new_instances_guard g;
+
+    container c1, c2;
+    c1.set_shrink_policy(disabled_shrink_policy());
+    mass_push_back(c2, {1, 2, 3});
+    swap(c1, c2);
+    EXPECT_TRUE(c1.get_shrink_policy().enabled);
+    EXPECT_FALSE(c2.get_shrink_policy().enabled);
+    expect_eq(c1, {1, 2, 3});
+}
+
+namespace
+{
+    struct allocation_counts
+    {
+        size_t allocations = 0;
+        size_t deallocations = 0;
+        size_t live_elements = 0;
+    };
+
+    // stateful allocator: counts into the allocation_counts it was made with; copies made by
+    // select_on_container_copy_construction get id + 100 so the tests can tell them apart
+    template <typename T, bool Propagate>
+    struct counting_allocator
+    {
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::integral_constant<bool, Propagate>;
+        using propagate_on_container_swap = std::integral_constant<bool, Propagate>;
+
+        template <typename U>
+        struct rebind
+        {
+            using other = counting_allocator<U, Propagate>;
+        };
+
+        counting_allocator(allocation_counts* counts, int id)
+            : counts(counts), id(id)
+        {}
+
+        template <typename U>
+        counting_allocator(counting_allocator<U, Propagate> const& other)
+            : counts(other.counts), id(other.id)
+        {}
+
+        T* allocate(size_t n)
+        {
+            ++counts->allocations;
+            counts->live_elements += n;
+            return std::allocator<T>().allocate(n);
+        }
+
+        void deallocate(T* p, size_t n)
+        {
+            ++counts->deallocations;
+            EXPECT_LE(n, counts->live_elements);
+            counts->live_elements -= n;
+            std::allocator<T>().deallocate(p, n);
+        }
+
+        counting_allocator select_on_container_copy_construction() const
+        {
+            return counting_allocator(counts, id + 100);
+        }
+
+        friend bool operator==(counting_allocator const& a, counting_allocator const& b)
+        {
+            return a.counts == b.counts && a.id == b.id;
+        }
+
+        friend bool operator!=(counting_allocator const& a, counting_allocator const& b)
+        {
+            return !(a == b);
+        }
+
+        allocation_counts* counts;
+        int id;
+    };
+
+    void expect_balanced(allocation_counts const& counts)
+    {
+        EXPECT_EQ(counts.allocations, counts.deallocations);
+        EXPECT_EQ(0u, counts.live_elements);
+    }
+}
+
+TEST(allocator, allocate_deallocate_balance)
+{
+    counted::no_new_instances_guard g;
+
+    allocation_counts counts;
+    {
+        using alloc = counting_allocator<counted, false>;
+        my_deq<counted, alloc> c{alloc(&counts, 1)};
+        for (int i = 0; i != 100; ++i)
+            c.push_back(i);
+        for (int i = 0; i != 95; ++i)
+            c.pop_front();
+        c.push_front(-1);
+        EXPECT_LT(1u, counts.allocations);
+        EXPECT_EQ(1, c.get_allocator().id);
+        c.clear();
+        EXPECT_TRUE(c.empty());
+    }
+    expect_balanced(counts);
+}
+
+TEST(allocator, copy_ctor_selects_allocator)
+{
+    counted::no_new_instances_guard g;
+
+    allocation_counts counts;
+    {
+        using alloc = counting_allocator<counted, false>;
+        my_deq<counted, alloc> c{alloc(&counts, 1)};
+        mass_push_back(c, {1, 2, 3});
+
+        size_t before = counts.allocations;
+        my_deq<counted, alloc> copy(c);
+        EXPECT_EQ(101, copy.get_allocator().id);
+        EXPECT_EQ(before + 1, counts.allocations);
+        expect_eq(copy, {1, 2, 3});
+    }
+    expect_balanced(counts);
+}
+
+TEST(allocator, copy_assignment_propagates)
+{
+    counted::no_new_instances_guard g;
+
+    allocation_counts counts1, counts2;
+    {
+        using alloc = counting_allocator<counted, true>;
+        my_deq<counted, alloc> c1{alloc(&counts1, 1)};
+        my_deq<counted, alloc> c2{alloc(&counts2, 2)};
+        mass_push_back(c1, {1, 2, 3});
+        mass_push_back(c2, {4, 5});
+
+        size_t before2 = counts2.allocations;
+        c2 = c1;
+        EXPECT_EQ(1, c2.get_allocator().id);
+        EXPECT_EQ(&counts1, c2.get_allocator().counts);
+        EXPECT_EQ(before2, counts2.allocations);
+        // c2's old buffer went back to the allocator that made it
+        expect_balanced(counts2);
+        expect_eq(c2, {1, 2, 3});
+
+        c2.push_back(4);
+        expect_eq(c1, {1, 2, 3});
+    }
+    expect_balanced(counts1);
+}
+
+TEST(allocator, copy_assignment_does_not_propagate)
+{
+    counted::no_new_instances_guard g;
+
+    allocation_counts counts1, counts2;
+    {
+        using alloc = counting_allocator<counted, false>;
+        my_deq<counted, alloc> c1{alloc(&counts1, 1)};
+        my_deq<counted, alloc> c2{alloc(&counts2, 2)};
+        mass_push_back(c1, {1, 2, 3});
+        mass_push_back(c2, {4, 5});
+
+        size_t before1 = counts1.allocations;
+        size_t before2 = counts2.allocations;
+        c2 = c1;
+        EXPECT_EQ(2, c2.get_allocator().id);
+        EXPECT_EQ(before1, counts1.allocations);
+        EXPECT_EQ(before2 + 1, counts2.allocations);
+        expect_eq(c2, {1, 2, 3});
+    }
+    expect_balanced(counts1);
+    expect_balanced(counts2);
+}
+
+TEST(allocator, swap_propagates)
+{
+    counted::no_new_instances_guard g;
+
+    allocation_counts counts1, counts2;
+    {
+        using alloc = counting_allocator<counted, true>;
+        my_deq<counted, alloc> c1{alloc(&counts1, 1)};
+        my_deq<counted, alloc> c2{alloc(&counts2, 2)};
+        mass_push_back(c1, {1, 2, 3});
+        mass_push_back(c2, {4, 5});
+        swap(c1, c2);
+        EXPECT_EQ(2, c1.get_allocator().id);
+        EXPECT_EQ(1, c2.get_allocator().id);
+        expect_eq(c1, {4, 5});
+        expect_eq(c2, {1, 2, 3});
+        for (int i = 0; i != 50; ++i)
+            c1.push_back(i);
+    }
+    expect_balanced(counts1);
+    expect_balanced(counts2);
+}
@@ -5,14 +5,20 @@
 #ifndef DEC_my_deq_H
 #define DEC_my_deq_H
 
+#include <algorithm>
 #include <iostream>
+#include <memory>
 #include <assert.h>
 
+#include "ring_spans.h"
+
 const int START_CAPACITY = 8;
 
-template <typename T>
+template <typename T, typename Allocator = std::allocator<T>>
 struct my_deq {
 private:
+    using alloc_traits = std::allocator_traits<Allocator>;
+
     template <typename U>
     struct my_iterator {
         using iterator_category = std::random_access_iterator_tag;
@@ -165,10 +171,30 @@ public:
     using const_iterator = my_iterator<T const>;
     using reverse_iterator = std::reverse_iterator<iterator>;
     using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+    using allocator_type = Allocator;
+
+    // By default pop_front/pop_back shrink the buffer to capacity / shrink_ratio once
+    // size * trigger_ratio < capacity; trigger_ratio > shrink_ratio leaves room to grow again before the
+    // next reallocation. Clear enabled to keep the capacity. The policy is copied and swapped along with
+    // the contents.
+    struct shrink_policy {
+        bool enabled = true;
+        size_t trigger_ratio = 4;
+        size_t shrink_ratio = 2;
+        size_t min_capacity = START_CAPACITY;
+    };
+
+    struct shrink_stats {
+        size_t shrinks = 0;
+        size_t failed_shrinks = 0;
+        size_t elements_moved = 0;
+    };
 
     my_deq();
-    my_deq(size_t capacity);
+    explicit my_deq(Allocator const &);
+    my_deq(size_t capacity, Allocator const & = Allocator());
     my_deq(my_deq const &);
+    my_deq(my_deq const &, Allocator const &);
     my_deq& operator=(my_deq const &);
     ~my_deq();
 
@@ -203,8 +229,17 @@ public:
     bool empty() const;
     void clear();
 
+    ring_spans<T> as_spans();
+    ring_spans<T const> as_spans() const;
+
     void swap(my_deq &);
 
+    Allocator get_allocator() const;
+
+    void set_shrink_policy(shrink_policy const &);
+    shrink_policy get_shrink_policy() const;
+    shrink_stats get_shrink_stats() const;
+
 private:
 
     size_t head_;
@@ -212,6 +247,9 @@ private:
     size_t size_;
     size_t capacity_;
     T * data_;
+    Allocator alloc_;
+    shrink_policy shrink_policy_;
+    shrink_stats shrink_stats_;
 
     //------------------------------------------------------------------
     //------------------ METHODS FOR MY IMPLEMENTATIONS ----------------
@@ -219,176 +257,232 @@ private:
 
     void ensure_capacity(size_t);
     void fixup();
+    void shrink_if_sparse();
+    template <bool PropagateAllocator>
+    void swap_storage(my_deq &);
 
 };
 
-template<typename T>
-my_deq<T>::my_deq():
+template<typename T, typename Allocator>
+my_deq<T, Allocator>::my_deq():
+        head_(0),
+        tail_(0),
+        size_(0),
+        capacity_(0),
+        data_(nullptr),
+        alloc_()
+{}
+
+template<typename T, typename Allocator>
+my_deq<T, Allocator>::my_deq(Allocator const & alloc):
         head_(0),
         tail_(0),
         size_(0),
         capacity_(0),
-        data_(nullptr)
+        data_(nullptr),
+        alloc_(alloc)
 {}
 
-template<typename T>
-my_deq<T>::my_deq(size_t capacity):
+template<typename T, typename Allocator>
+my_deq<T, Allocator>::my_deq(size_t capacity, Allocator const & alloc):
         head_(0),
         tail_(0),
         size_(0),
         capacity_(capacity),
-        data_(static_cast<T*>(operator new(capacity * sizeof(T))))
+        data_(nullptr),
+        alloc_(alloc)
+{
+    data_ = alloc_traits::allocate(alloc_, capacity_);
+}
+
+template<typename T, typename Allocator>
+my_deq<T, Allocator>::my_deq(my_deq const & other):
+        my_deq(other, alloc_traits::select_on_container_copy_construction(other.alloc_))
 {}
 
-template<typename T>
-my_deq<T>::my_deq(my_deq const & other):
+template<typename T, typename Allocator>
+my_deq<T, Allocator>::my_deq(my_deq const & other, Allocator const & alloc):
         head_(other.head_),
         tail_(other.tail_),
         size_(other.size_),
         capacity_(other.capacity_),
-        data_(nullptr)
+        data_(nullptr),
+        alloc_(alloc),
+        shrink_policy_(other.shrink_policy_)
 {
     if (capacity_ == 0) {
         return;
     }
 
-    data_ = static_cast<T*>(operator new(capacity_ * sizeof(T)));
+    data_ = alloc_traits::allocate(alloc_, capacity_);
 
     for (size_t i = 0, j = head_; i < size_; ++i, j = (j + 1) % capacity_) {
         try {
-            new (data_ + j) T(other.data_[j]);
+            alloc_traits::construct(alloc_, data_ + j, other.data_[j]);
         } catch(...) {
             for (size_t j = 0, k = head_; j < i; ++j, k = (k + 1) % capacity_) {
-                data_[k].~T();
+                alloc_traits::destroy(alloc_, data_ + k);
             }
 
-            operator delete(data_);
+            alloc_traits::deallocate(alloc_, data_, capacity_);
             throw;
         }
     }
 }
 
-template<typename T>
-my_deq<T>& my_deq<T>::operator=(my_deq const & other) {
+template<typename T, typename Allocator>
+my_deq<T, Allocator>& my_deq<T, Allocator>::operator=(my_deq const & other) {
     if (this != &other) {
-        my_deq copy(other);
-        this->swap(copy);
+        // the copy is built with the allocator this container should end up with
+        my_deq copy(other, alloc_traits::propagate_on_container_copy_assignment::value ? other.alloc_ : alloc_);
+        this->template swap_storage<alloc_traits::propagate_on_container_copy_assignment::value>(copy);
+        shrink_policy_ = other.shrink_policy_;
     }
 
     return *this;
 }
 
-template<typename T>
-my_deq<T>::~my_deq() {
+template<typename T, typename Allocator>
+my_deq<T, Allocator>::~my_deq() {
     if (capacity_ == 0)
         return;
 
     for (size_t i = 0, pos = head_; i < size_; ++i, pos = (pos + 1) % capacity_)
-        data_[pos].~T();
-    operator delete(data_);
+        alloc_traits::destroy(alloc_, data_ + pos);
+    alloc_traits::deallocate(alloc_, data_, capacity_);
 }
 
-template<typename T>
-void my_deq<T>::push_back(const T & value) {
+template<typename T, typename Allocator>
+void my_deq<T, Allocator>::push_back(const T & value) {
     ensure_capacity(size_ + 2);
 
     if (size_ == 0) {
-        new (data_) T(value);
+        alloc_traits::construct(alloc_, data_, value);
     } else {
         size_t copy_tail = (tail_ + 1) % capacity_;
-        new (data_ + copy_tail) T(value);
+        alloc_traits::construct(alloc_, data_ + copy_tail, value);
         tail_ = copy_tail;
     }
 
     size_++;
 }
 
-template<typename T>
-void my_deq<T>::push_front(const T & value) {
+template<typename T, typename Allocator>
+void my_deq<T, Allocator>::push_front(const T & value) {
     ensure_capacity(size_ + 2);
 
     if (size_ == 0) {
-        new (data_) T(value);
+        alloc_traits::construct(alloc_, data_, value);
     } else {
         size_t copy_head = (head_ != 0 ? head_ - 1 : capacity_ - 1);
-        new (data_ + copy_head) T(value);
+        alloc_traits::construct(alloc_, data_ + copy_head, value);
         head_ = copy_head;
     }
 
     size_++;
 }
 
-template<typename T>
-void my_deq<T>::pop_back() {
+template<typename T, typename Allocator>
+void my_deq<T, Allocator>::pop_back() {
     assert(size_ > 0);
 
-    data_[tail_].~T();
+    alloc_traits::destroy(alloc_, data_ + tail_);
     tail_ = (tail_ != 0? tail_ - 1 : capacity_ - 1);
     size_--;
     fixup();
 }
 
-template<typename T>
-void my_deq<T>::pop_front() {
+template<typename T, typename Allocator>
+void my_deq<T, Allocator>::pop_front() {
     assert(size_ > 0);
 
-    data_[head_].~T();
+    alloc_traits::destroy(alloc_, data_ + head_);
     head_ = (head_ + 1) % capacity_;
     size_--;
     fixup();
 }
 
-template<typename T>
-T &my_deq<T>::front() const {
+template<typename T, typename Allocator>
+T &my_deq<T, Allocator>::front() const {
     assert(size_ > 0);
 
     return data_[head_];
 }
 
-template<typename T>
-T &my_deq<T>::back() const {
+template<typename T, typename Allocator>
+T &my_deq<T, Allocator>::back() const {
     assert(size_ > 0);
 
     return data_[tail_];
 }
 
-template<typename T>
-void my_deq<T>::ensure_capacity(size_t size) {
+template<typename T, typename Allocator>
+void my_deq<T, Allocator>::ensure_capacity(size_t size) {
     if (size <= capacity_) {
         return;
     }
 
     if (capacity_ == 0) {
+        data_ = alloc_traits::allocate(alloc_, 2);
         capacity_ = 2;
-        data_ = static_cast<T*>(operator new(capacity_ * sizeof(T)));
         return;
     }
 
-    my_deq<T> material(2 * capacity_ - 1);
+    my_deq<T, Allocator> material(2 * capacity_ - 1, alloc_);
 
     for (size_t i = 0, pos = head_; i < size_; ++i, pos = (pos + 1) % capacity_) {
         material.push_back(data_[pos]);
     }
 
-    this->swap(material);
+    this->template swap_storage<false>(material);
 }
 
-template<typename T>
-void my_deq<T>::fixup() {
+template<typename T, typename Allocator>
+void my_deq<T, Allocator>::fixup() {
     if (empty()) {
         head_ = tail_ = 0;
     }
+    shrink_if_sparse();
 }
 
-template<typename T>
-T &my_deq<T>::operator[](size_t pos) const {
+template<typename T, typename Allocator>
+void my_deq<T, Allocator>::shrink_if_sparse() {
+    shrink_policy const & policy = shrink_policy_;
+    if (!policy.enabled || capacity_ <= policy.min_capacity || size_ * policy.trigger_ratio >= capacity_) {
+        return;
+    }
+
+    size_t new_capacity = std::max(std::max(capacity_ / policy.shrink_ratio, policy.min_capacity), size_ + 2);
+    if (new_capacity >= capacity_) {
+        return;
+    }
+
+    // shrinking is only an optimization, a pop must not fail because of it
+    try {
+        my_deq<T, Allocator> material(new_capacity, alloc_);
+
+        for (size_t i = 0, pos = head_; i < size_; ++i, pos = (pos + 1) % capacity_) {
+            material.push_back(data_[pos]);
+        }
+
+        this->template swap_storage<false>(material);
+    } catch (...) {
+        shrink_stats_.failed_shrinks++;
+        return;
+    }
+    shrink_stats_.shrinks++;
+    shrink_stats_.elements_moved += size_;
+}
+
+template<typename T, typename Allocator>
+T &my_deq<T, Allocator>::operator[](size_t pos) const {
     assert(pos < size_);
 
     return data_[(head_ + pos) % capacity_];
 }
 
-template<typename T>
-typename my_deq<T>::iterator my_deq<T>::insert(typename my_deq<T>::const_iterator it, const T & value) {
+template<typename T, typename Allocator>
+typename my_deq<T, Allocator>::iterator my_deq<T, Allocator>::insert(typename my_deq<T, Allocator>::const_iterator it, const T & value) {
     if (empty()) {
         push_back(value);
         return begin();
@@ -415,8 +509,8 @@ typename my_deq<T>::iterator my_deq<T>::insert(typename my_deq<T>::const_iterato
     return begin() + pos;
 }
 
-template<typename T>
-typename my_deq<T>::iterator my_deq<T>::erase(typename my_deq<T>::const_iterator it) {
+template<typename T, typename Allocator>
+typename my_deq<T, Allocator>::iterator my_deq<T, Allocator>::erase(typename my_deq<T, Allocator>::const_iterator it) {
     assert(size_ > 0);
 
     size_t pos = it.index;
@@ -440,25 +534,48 @@ typename my_deq<T>::iterator my_deq<T>::erase(typename my_deq<T>::const_iterator
     return begin() + pos;
 }
 
-template<typename T>
-size_t my_deq<T>::size() const {
+template<typename T, typename Allocator>
+size_t my_deq<T, Allocator>::size() const {
     return size_;
 }
 
-template<typename T>
-bool my_deq<T>::empty() const {
+template<typename T, typename Allocator>
+bool my_deq<T, Allocator>::empty() const {
     return size_ == 0;
 }
 
-template<typename T>
-void my_deq<T>::clear() {
-    my_deq cl;
-    this->swap(cl);
+template<typename T, typename Allocator>
+ring_spans<T> my_deq<T, Allocator>::as_spans() {
+    return make_ring_spans(data_, capacity_, head_, size_);
 }
 
-template<typename T>
-void my_deq<T>::swap(my_deq & other) {
+template<typename T, typename Allocator>
+ring_spans<T const> my_deq<T, Allocator>::as_spans() const {
+    return make_ring_spans<T const>(data_, capacity_, head_, size_);
+}
+
+template<typename T, typename Allocator>
+void my_deq<T, Allocator>::clear() {
+    my_deq cl(alloc_);
+    this->template swap_storage<false>(cl);
+}
+
+template<typename T, typename Allocator>
+void my_deq<T, Allocator>::swap(my_deq & other) {
+    // without propagation the buffers are only exchangeable between equal allocators
+    assert(alloc_traits::propagate_on_container_swap::value || alloc_ == other.alloc_);
+
+    swap_storage<alloc_traits::propagate_on_container_swap::value>(other);
+    std::swap(shrink_policy_, other.shrink_policy_);
+}
+
+template<typename T, typename Allocator>
+template<bool PropagateAllocator>
+void my_deq<T, Allocator>::swap_storage(my_deq & other) {
     using std::swap;
+    if constexpr (PropagateAllocator) {
+        swap(alloc_, other.alloc_);
+    }
     swap(data_, other.data_);
     swap(size_, other.size_);
     swap(capacity_, other.capacity_);
@@ -466,48 +583,71 @@ void my_deq<T>::swap(my_deq & other) {
     swap(tail_, other.tail_);
 }
 
-template<typename T>
-typename my_deq<T>::iterator my_deq<T>::begin() {
+template<typename T, typename Allocator>
+Allocator my_deq<T, Allocator>::get_allocator() const {
+    return alloc_;
+}
+
+template<typename T, typename Allocator>
+void my_deq<T, Allocator>::set_shrink_policy(shrink_policy const & policy) {
+    assert(!policy.enabled || policy.trigger_ratio > policy.shrink_ratio);
+    assert(!policy.enabled || policy.shrink_ratio > 1);
+
+    shrink_policy_ = policy;
+}
+
+template<typename T, typename Allocator>
+typename my_deq<T, Allocator>::shrink_policy my_deq<T, Allocator>::get_shrink_policy() const {
+    return shrink_policy_;
+}
+
+template<typename T, typename Allocator>
+typename my_deq<T, Allocator>::shrink_stats my_deq<T, Allocator>::get_shrink_stats() const {
+    return shrink_stats_;
+}
+
+template<typename T, typename Allocator>
+typename my_deq<T, Allocator>::iterator my_deq<T, Allocator>::begin() {
     return iterator(data_, 0, head_, capacity_);
 }
 
-template<typename T>
-typename my_deq<T>::const_iterator my_deq<T>::begin() const {
+template<typename T, typename Allocator>
+typename my_deq<T, Allocator>::const_iterator my_deq<T, Allocator>::begin() const {
     return const_iterator(data_, 0, head_, capacity_);
 }
 
-template<typename T>
-typename my_deq<T>::iterator my_deq<T>::end() {
+template<typename T, typename Allocator>
+typename my_deq<T, Allocator>::iterator my_deq<T, Allocator>::end() {
     return iterator(data_, size_, head_, capacity_);
 }
 
-template<typename T>
-typename my_deq<T>::const_iterator my_deq<T>::end() const {
+template<typename T, typename Allocator>
+typename my_deq<T, Allocator>::const_iterator my_deq<T, Allocator>::end() const {
     return const_iterator(data_, size_, head_, capacity_);
 }
 
-template<typename T>
-typename my_deq<T>::reverse_iterator my_deq<T>::rbegin() {
+template<typename T, typename Allocator>
+typename my_deq<T, Allocator>::reverse_iterator my_deq<T, Allocator>::rbegin() {
     return reverse_iterator(end());
 }
 
-template<typename T>
-typename my_deq<T>::const_reverse_iterator my_deq<T>::rbegin() const {
+template<typename T, typename Allocator>
+typename my_deq<T, Allocator>::const_reverse_iterator my_deq<T, Allocator>::rbegin() const {
     return const_reverse_iterator(end());
 }
 
-template<typename T>
-typename my_deq<T>::reverse_iterator my_deq<T>::rend() {
+template<typename T, typename Allocator>
+typename my_deq<T, Allocator>::reverse_iterator my_deq<T, Allocator>::rend() {
     return reverse_iterator(begin());
 }
 
-template<typename T>
-typename my_deq<T>::const_reverse_iterator my_deq<T>::rend() const {
+template<typename T, typename Allocator>
+typename my_deq<T, Allocator>::const_reverse_iterator my_deq<T, Allocator>::rend() const {
     return const_reverse_iterator(begin());
 }
 
-template<typename T>
-void swap(my_deq<T> & l, my_deq<T> & r) {
+template<typename T, typename Allocator>
+void swap(my_deq<T, Allocator> & l, my_deq<T, Allocator> & r) {
     l.swap(r);
 }
 
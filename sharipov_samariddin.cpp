@@ -3,3 +3,149 @@
 using container = Array_List<counted>;
 
 #include "tests.inl"
+
+#include <cstdio>
+
+namespace
+{
+    using int_list = Array_List<int>;
+
+    std::vector<int> list_contents(int_list const& c)
+    {
+        std::vector<int> res;
+        for (size_t i = 0; i != c.size(); ++i)
+            res.push_back(c[i]);
+        return res;
+    }
+
+    int_list save_and_load(int_list const& c)
+    {
+        int fds[2];
+        EXPECT_EQ(0, pipe(fds));
+        c.save(fds[1]);
+        close(fds[1]);
+        int_list res;
+        res.load(fds[0]);
+        char extra;
+        EXPECT_EQ(0, read(fds[0], &extra, 1));
+        close(fds[0]);
+        return res;
+    }
+
+    // a temporary file holding the first bytes bytes of c's checkpoint, positioned at the start
+    FILE* truncated_checkpoint(int_list const& c, off_t bytes)
+    {
+        FILE* f = std::tmpfile();
+        EXPECT_NE(nullptr, f);
+        c.save(fileno(f));
+        EXPECT_EQ(0, ftruncate(fileno(f), bytes));
+        EXPECT_EQ(0, lseek(fileno(f), 0, SEEK_SET));
+        return f;
+    }
+
+    void expect_load_fails(FILE* f, int_list& c, std::vector<int> const& unchanged)
+    {
+        EXPECT_THROW(c.load(fileno(f)), std::runtime_error);
+        EXPECT_EQ(unchanged, list_contents(c));
+        std::fclose(f);
+    }
+}
+
+TEST(serialization, empty)
+{
+    int_list c;
+    int_list loaded = save_and_load(c);
+    EXPECT_EQ(0u, loaded.size());
+    loaded.push_back(1);
+    EXPECT_EQ(std::vector<int>{1}, list_contents(loaded));
+}
+
+TEST(serialization, contiguous)
+{
+    // only push_front: the elements occupy one segment starting at slot 0
+    int_list c;
+    for (int i = 0; i != 5; ++i)
+        c.push_front(i);
+    int_list loaded = save_and_load(c);
+    EXPECT_EQ(list_contents(c), list_contents(loaded));
+    EXPECT_EQ((std::vector<int>{4, 3, 2, 1, 0}), list_contents(loaded));
+}
+
+TEST(serialization, wrapped)
+{
+    // push_back moves tail below slot 0 and push_front moves head up from it, so the contents wrap
+    int_list c;
+    for (int i = 0; i != 4; ++i)
+    {
+        c.push_back(i);
+        c.push_front(-i - 1);
+    }
+    int_list loaded = save_and_load(c);
+    EXPECT_EQ((std::vector<int>{-4, -3, -2, -1, 0, 1, 2, 3}), list_contents(loaded));
+
+    loaded.push_back(4);
+    loaded.push_front(-5);
+    EXPECT_EQ(-5, loaded.front());
+    EXPECT_EQ(4, loaded.back());
+    EXPECT_EQ(10u, loaded.size());
+}
+
+TEST(serialization, load_replaces_contents)
+{
+    int_list c;
+    c.push_back(7);
+    int_list other;
+    for (int i = 0; i != 20; ++i)
+        other.push_back(i);
+    int fds[2];
+    ASSERT_EQ(0, pipe(fds));
+    c.save(fds[1]);
+    close(fds[1]);
+    other.load(fds[0]);
+    close(fds[0]);
+    EXPECT_EQ(std::vector<int>{7}, list_contents(other));
+}
+
+TEST(serialization, truncated_header)
+{
+    int_list src;
+    src.push_back(1);
+    int_list c;
+    c.push_back(5);
+    c.push_front(6);
+    expect_load_fails(truncated_checkpoint(src, 10), c, {6, 5});
+}
+
+TEST(serialization, bad_header)
+{
+    int_list src;
+    src.push_back(1);
+    FILE* f = truncated_checkpoint(src, 24 + sizeof(int));
+    uint64_t wrong_size = sizeof(long long);
+    ASSERT_EQ(ssize_t(sizeof(wrong_size)), pwrite(fileno(f), &wrong_size, sizeof(wrong_size), 8));
+
+    int_list c;
+    c.push_back(5);
+    expect_load_fails(f, c, {5});
+
+    f = std::tmpfile();
+    ASSERT_NE(nullptr, f);
+    char garbage[32] = "not an Array_List checkpoint";
+    ASSERT_EQ(ssize_t(sizeof(garbage)), write(fileno(f), garbage, sizeof(garbage)));
+    lseek(fileno(f), 0, SEEK_SET);
+    expect_load_fails(f, c, {5});
+}
+
+TEST(serialization, short_read)
+{
+    int_list src;
+    for (int i = 0; i != 6; ++i)
+        src.push_back(i);
+    int_list c;
+    c.push_back(5);
+    c.push_front(6);
+    // the header promises six elements but only three and a half follow
+    expect_load_fails(truncated_checkpoint(src, 24 + 3 * sizeof(int) + 2), c, {6, 5});
+    c.push_back(4);
+    EXPECT_EQ((std::vector<int>{6, 5, 4}), list_contents(c));
+}
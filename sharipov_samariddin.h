@@ -4,10 +4,17 @@
 # include<iostream>
 # include<cmath>
 # include<math.h>
+# include<cerrno>
+# include<cstdint>
+# include<stdexcept>
+# include<type_traits>
+# include<sys/uio.h>
+# include<unistd.h>
 
 
 
-template<typename T>
+// N > 0 keeps up to N elements in storage inside the object, the heap is used only past that.
+template<typename T, size_t N = 0>
 
 class Array_List
 {
@@ -270,7 +277,7 @@ public:
     typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
 
 
-    Array_List(): a(nullptr), ca_len(0), len(0), head(0), tail(0){}
+    Array_List(): a(inline_storage()), ca_len(INLINE_CAP), len(0), head(0), tail(0){}
     Array_List(const Array_List& q):Array_List(){
             for(const_iterator it = q.begin(); it != q.end(); it ++){
 
@@ -282,7 +289,7 @@ public:
         for(const_iterator it = begin(); it != end(); it ++){
             (*it).~T();
         }
-        operator delete(a);
+        release(a);
     }
 
     Array_List& operator=(Array_List& other){
@@ -296,7 +303,7 @@ public:
 //        for(const_iterator it = other.begin(); it != other.end(); it ++){
 //            push_back(*it);
 //        }
-        Array_List<T> oth(other);
+        Array_List oth(other);
         swap(*this, oth);
         return *this;
 
@@ -321,39 +328,19 @@ public:
     }
 
     iterator insert(const_iterator no, T const& value){
-        int x = no.position();
-       // std::cout << a[x]<<'\n';
-        int kol;
-        if(x > head){
-            kol = ca_len - x + head ;
-        } else{
-            kol = head - x;
-        }
-        if(closer(x)){
-
+        int ind = ca_len == 0 ? 0 : (head - 1 - no.position() + ca_len) % ca_len;
+        if(ind < (int) size() / 2){
             push_front(value);
-            x = (head - kol + ca_len  - 1) % ca_len;
-            int t = head - 1;
-
-            while(x != (t - 1 + ca_len) % ca_len){
-                std::swap(a[t], a[(t - 1 + ca_len) % ca_len]);
-                t--;
-                t %= ca_len;
+            for(int i = 0; i < ind; i ++){
+                std::swap((*this)[i], (*this)[i + 1]);
             }
-            return iterator(a, t, ca_len);
         } else{
-
-
             push_back(value);
-            x = (head - kol + ca_len) % ca_len;
-            int t = tail;
-            while(x != (t + 1) & ca_len){
-                std::swap(a[t], a[(t + 1) % ca_len]);
-                t++;
-                t %= ca_len;
+            for(int i = (int) size() - 1; i > ind; i --){
+                std::swap((*this)[i], (*this)[i - 1]);
             }
-            return iterator(a, t, ca_len);
         }
+        return iterator(a, (head - 1 - ind + ca_len) % ca_len, ca_len);
     }
 
     iterator erase(const_iterator no){
@@ -442,13 +429,14 @@ public:
 
     void copy(){
 
-        T* new_a = static_cast<T*>(operator new(sizeof(T) * std::max(10, ca_len * 2)));
+        int new_ca_len = std::max(10, ca_len * 2);
+        T* new_a = static_cast<T*>(operator new(sizeof(T) * new_ca_len));
 
         int new_head = 0;
 
         try{
             if(head >= tail){
-                for(int i = tail; i < head; i --){
+                for(int i = tail; i < head; i ++){
                     new (&new_a[new_head]) T (a[i]);
                     new_head++;
                 }
@@ -462,15 +450,18 @@ public:
                     new_head++;
                 }
             }
-        } catch (std::runtime_error &e){
+        } catch (...){
+            for(int i = 0; i < new_head; i ++){
+                new_a[i].~T();
+            }
             operator delete(new_a);
+            throw;
         }
-        if(ca_len == 0){
-            ca_len = 10;
-        } else{
-            ca_len *= 2;
+        for(const_iterator it = begin(); it != end(); it ++){
+            (*it).~T();
         }
-        operator delete(a);
+        ca_len = new_ca_len;
+        release(a);
         a = new_a;
         head = new_head;
         tail = 0;
@@ -566,12 +557,150 @@ public:
     size_t size() const{
         return len;
     }
-    template<typename S>
-   friend void swap(Array_List<S>& first, Array_List<S>& second);
+
+    // Binary checkpoint for trivially copyable T: a header and then the elements as they lie
+    // in storage (back to front), written straight from the one or two occupied segments.
+    void save(int fd) const{
+        static_assert(std::is_trivially_copyable<T>::value, "elements are written as raw bytes");
+        file_header h = {FILE_MAGIC, sizeof(T), (uint64_t) len};
+        iovec iov[3];
+        int cnt = 0;
+        iov[cnt++] = {&h, sizeof(h)};
+        if(len != 0){
+            if(tail < head){
+                iov[cnt++] = {a + tail, sizeof(T) * (head - tail)};
+            } else{
+                iov[cnt++] = {a + tail, sizeof(T) * (ca_len - tail)};
+                if(head != 0){
+                    iov[cnt++] = {a, sizeof(T) * head};
+                }
+            }
+        }
+        iovec *cur = iov;
+        while(cnt != 0){
+            ssize_t done = writev(fd, cur, cnt);
+            if(done < 0){
+                if(errno == EINTR){
+                    continue;
+                }
+                throw std::runtime_error("Array_List::save: write failed");
+            }
+            // short write: skip what went out and retry with the rest
+            while(cnt != 0 && (size_t) done >= cur->iov_len){
+                done -= cur->iov_len;
+                cur++;
+                cnt--;
+            }
+            if(cnt != 0){
+                cur->iov_base = static_cast<char*>(cur->iov_base) + done;
+                cur->iov_len -= done;
+            }
+        }
+    }
+
+    // Replaces the contents with a checkpoint written by save, reading the elements directly into new storage.
+    void load(int fd){
+        static_assert(std::is_trivially_copyable<T>::value, "elements are read as raw bytes");
+        file_header h;
+        read_all(fd, &h, sizeof(h));
+        if(h.magic != FILE_MAGIC || h.element_size != sizeof(T) || h.size > (uint64_t) INT32_MAX / 2){
+            throw std::runtime_error("Array_List::load: bad header");
+        }
+        int new_len = (int) h.size;
+        int new_ca_len = std::max(10, new_len * 2);
+        T* new_a = static_cast<T*>(operator new(sizeof(T) * new_ca_len));
+        try{
+            read_all(fd, new_a, sizeof(T) * new_len);
+        } catch (...){
+            operator delete(new_a);
+            throw;
+        }
+        release(a);
+        a = new_a;
+        ca_len = new_ca_len;
+        len = new_len;
+        tail = 0;
+        head = new_len;
+    }
+
+    template<typename S, size_t M>
+   friend void swap(Array_List<S, M>& first, Array_List<S, M>& second);
 
 private:
+    static const uint64_t FILE_MAGIC = 0x7473696c5f797261; // "ary_list"
+
+    struct file_header{
+        uint64_t magic;
+        uint64_t element_size;
+        uint64_t size;
+    };
+
+    // the two reserved slots push_back/push_front keep free, plus one for the element being added
+    static const int INLINE_CAP = N == 0 ? 0 : (int) N + 3;
+
+    T* inline_storage(){
+        return N == 0 ? nullptr : reinterpret_cast<T*>(inline_buf);
+    }
+
+    bool is_inline() const{
+        return N != 0 && a == reinterpret_cast<const T*>(inline_buf);
+    }
+
+    // Swap with an inline list while this one is on the heap: the heap storage goes to other, and
+    // other's elements are copied into this object's (unused) inline storage. Nothing changes if a copy throws.
+    void take_inline(Array_List& other){
+        T* buf = inline_storage();
+        int n = 0;
+        try{
+            for(int i = other.tail; n != other.len; other.plus(i)){
+                new (&buf[n]) T (other.a[i]);
+                n++;
+            }
+        } catch (...){
+            for(int i = 0; i < n; i ++){
+                buf[i].~T();
+            }
+            throw;
+        }
+        for(const_iterator it = other.begin(); it != other.end(); it ++){
+            (*it).~T();
+        }
+        other.a = a;
+        other.ca_len = ca_len;
+        other.len = len;
+        other.head = head;
+        other.tail = tail;
+        a = buf;
+        ca_len = INLINE_CAP;
+        len = n;
+        head = n;
+        tail = 0;
+    }
+
+    void release(T* p){
+        if(p != inline_storage()){
+            operator delete(p);
+        }
+    }
+
+    static void read_all(int fd, void* dst, size_t bytes){
+        char* p = static_cast<char*>(dst);
+        while(bytes != 0){
+            ssize_t done = read(fd, p, bytes);
+            if(done < 0 && errno == EINTR){
+                continue;
+            }
+            if(done <= 0){
+                throw std::runtime_error("Array_List::load: read failed");
+            }
+            p += done;
+            bytes -= done;
+        }
+    }
+
     T* a = nullptr;
     int ca_len = 0, len = 0, head = 0, tail = 0;
+    alignas(T) unsigned char inline_buf[N == 0 ? 1 : sizeof(T) * INLINE_CAP];
 
 };
 
@@ -585,12 +714,34 @@ typename Array_List<T>::iterator operator-(typename Array_List<T>::iterator a, c
     return a-=b;
 }*/
 
-template <typename T>
-void swap(Array_List<T>& first, Array_List<T>& second){
-    std::swap(second.a, first.a);
-    std::swap(second.ca_len, first.ca_len);
-    std::swap(first.head, second.head);
-    std::swap(first.tail, second.tail);
+template <typename T, size_t N>
+void swap(Array_List<T, N>& first, Array_List<T, N>& second){
+    // inline storage cannot change owners, so inline elements are swapped or copied one by one
+    if(first.is_inline() && second.is_inline()){
+        Array_List<T, N>& shorter = first.len < second.len ? first : second;
+        Array_List<T, N>& longer = first.len < second.len ? second : first;
+        int common = shorter.len;
+        for(int i = 0; i < common; i ++){
+            std::swap(shorter[i], longer[i]);
+        }
+        // both fit inline, so none of this touches the heap
+        while(longer.len != common){
+            shorter.push_back(longer[shorter.len]);
+            longer.pop_back();
+        }
+        return;
+    }
+    if(first.is_inline()){
+        second.take_inline(first);
+    } else if(second.is_inline()){
+        first.take_inline(second);
+    } else{
+        std::swap(second.a, first.a);
+        std::swap(first.len, second.len);
+        std::swap(second.ca_len, first.ca_len);
+        std::swap(first.head, second.head);
+        std::swap(first.tail, second.tail);
+    }
 }
 
 #endif // ARRAY_LIST_H
@@ -0,0 +1,84 @@
+#include "sharipov_samariddin.h"
+#include <counted.h>
+using container = Array_List<counted, 4>;
+
+#include "tests.inl"
+
+TEST(inline_storage, swap_inline_inline)
+{
+    counted::no_new_instances_guard g;
+
+    container c1, c2;
+    mass_push_back(c1, {1, 2, 3});
+    mass_push_back(c2, {4});
+    swap(c1, c2);
+    expect_eq(c1, {4});
+    expect_eq(c2, {1, 2, 3});
+    swap(c1, c2);
+    expect_eq(c1, {1, 2, 3});
+    expect_eq(c2, {4});
+}
+
+TEST(inline_storage, swap_inline_heap)
+{
+    counted::no_new_instances_guard g;
+
+    container c1, c2;
+    mass_push_back(c1, {1, 2});
+    mass_push_front(c2, {3, 4, 5, 6, 7, 8, 9});
+    swap(c1, c2);
+    expect_eq(c1, {9, 8, 7, 6, 5, 4, 3});
+    expect_eq(c2, {1, 2});
+    swap(c1, c2);
+    expect_eq(c1, {1, 2});
+    expect_eq(c2, {9, 8, 7, 6, 5, 4, 3});
+}
+
+TEST(inline_storage, swap_stays_inline)
+{
+    Array_List<int, 4> c1, c2;
+    c1.push_back(1);
+    c1.push_front(0);
+    c2.push_back(2);
+    c2.push_back(3);
+    c2.push_back(4);
+
+    allocation_arena arena;
+    swap(c1, c2);
+    swap(c1, c1);
+    EXPECT_EQ(0u, arena.allocations());
+    EXPECT_EQ(3u, c1.size());
+    EXPECT_EQ(2, c1[0]);
+    EXPECT_EQ(4, c1[2]);
+    EXPECT_EQ(0, c2[0]);
+    EXPECT_EQ(1, c2[1]);
+}
+
+TEST(inline_storage, fault_injection_swap_inline_heap)
+{
+    faulty_run([]
+    {
+        container c1, c2;
+        {
+            fault_injection_disable dg;
+            mass_push_back(c1, {1, 2, 3});
+            mass_push_back(c2, {4, 5, 6, 7, 8, 9});
+        }
+
+        try
+        {
+            swap(c1, c2);
+        }
+        catch (...)
+        {
+            fault_injection_disable dg;
+            expect_eq(c1, {1, 2, 3});
+            expect_eq(c2, {4, 5, 6, 7, 8, 9});
+            throw;
+        }
+
+        fault_injection_disable dg;
+        expect_eq(c1, {4, 5, 6, 7, 8, 9});
+        expect_eq(c2, {1, 2, 3});
+    });
+}
@@ -3,3 +3,202 @@
 using container = deque<counted>;
 
 #include "tests.inl"
+
+#include <random>
+#include <set>
+
+TEST(min_max_heap, matches_multiset)
+{
+    counted::no_new_instances_guard g;
+
+    std::mt19937 rng(1);
+    min_max_heap<counted> h;
+    std::multiset<int> ref;
+    for (int i = 0; i != 100000; ++i)
+    {
+        unsigned op = rng() % 5;
+        if (op < 2 || ref.empty())
+        {
+            // a small range, so there are plenty of duplicates
+            int v = int(rng() % 1000);
+            h.push(v);
+            ref.insert(v);
+        }
+        else if (op == 2)
+        {
+            ASSERT_EQ(*ref.begin(), h.min());
+            h.pop_min();
+            ref.erase(ref.begin());
+        }
+        else if (op == 3)
+        {
+            ASSERT_EQ(*ref.rbegin(), h.max());
+            h.pop_max();
+            ref.erase(std::prev(ref.end()));
+        }
+        else
+        {
+            ASSERT_EQ(*ref.begin(), h.min());
+            ASSERT_EQ(*ref.rbegin(), h.max());
+        }
+        ASSERT_EQ(ref.size(), h.size());
+    }
+
+    // drain from both ends
+    while (!ref.empty())
+    {
+        ASSERT_EQ(*ref.rbegin(), h.max());
+        h.pop_max();
+        ref.erase(std::prev(ref.end()));
+        if (ref.empty())
+            break;
+        ASSERT_EQ(*ref.begin(), h.min());
+        h.pop_min();
+        ref.erase(ref.begin());
+    }
+    EXPECT_TRUE(h.empty());
+}
+
+TEST(min_max_heap, small_sizes)
+{
+    counted::no_new_instances_guard g;
+
+    min_max_heap<counted> h;
+    h.push(5);
+    EXPECT_EQ(5, h.min());
+    EXPECT_EQ(5, h.max());
+    h.push(3);
+    EXPECT_EQ(3, h.min());
+    EXPECT_EQ(5, h.max());
+    h.push(7);
+    EXPECT_EQ(7, h.max());
+    h.pop_max();
+    EXPECT_EQ(5, h.max());
+    h.pop_min();
+    EXPECT_EQ(5, h.min());
+    h.pop_max();
+    EXPECT_TRUE(h.empty());
+}
+
+TEST(min_max_heap, compare_and_swap)
+{
+    counted::no_new_instances_guard g;
+
+    min_max_heap<counted, std::greater<counted>> h;
+    for (int i = 0; i != 10; ++i)
+        h.push(i);
+    // with greater the "minimum" is the largest element
+    EXPECT_EQ(9, h.min());
+    EXPECT_EQ(0, h.max());
+
+    min_max_heap<counted, std::greater<counted>> other;
+    other.push(42);
+    swap(h, other);
+    EXPECT_EQ(1u, h.size());
+    EXPECT_EQ(42, h.min());
+    EXPECT_EQ(10u, other.size());
+    other.clear();
+    EXPECT_TRUE(other.empty());
+}
+
+namespace
+{
+    // {-4, ..., 5}; the first four elements were pushed to the front and wrap around the end of the buffer
+    container wrapped_deque()
+    {
+        container c;
+        for (int i = 0; i != 6; ++i)
+            c.push_back(i);
+        for (int i = -1; i != -5; --i)
+            c.push_front(i);
+        EXPECT_NE(0u, c.as_spans().array_two.size());
+        return c;
+    }
+
+    void expect_erase(container& c, size_t from, size_t to)
+    {
+        std::vector<int> expected = contents(c);
+        expected.erase(expected.begin() + from, expected.begin() + to);
+
+        container::iterator it = c.erase(c.begin() + from, c.begin() + to);
+        EXPECT_EQ(expected, contents(c)) << "erase [" << from << ", " << to << ")";
+        EXPECT_TRUE(it == c.begin() + from);
+        if (from != expected.size())
+            EXPECT_EQ(expected[from], *it);
+        else
+            EXPECT_TRUE(it == c.end());
+    }
+}
+
+TEST(range_erase, empty_range)
+{
+    counted::no_new_instances_guard g;
+
+    container c = wrapped_deque();
+    expect_erase(c, 3, 3);
+    expect_erase(c, 0, 0);
+    expect_erase(c, 10, 10);
+    EXPECT_EQ(10u, c.size());
+
+    container e;
+    EXPECT_TRUE(e.erase(e.begin(), e.end()) == e.end());
+    EXPECT_TRUE(e.empty());
+}
+
+TEST(range_erase, whole_range)
+{
+    counted::no_new_instances_guard g;
+
+    container c = wrapped_deque();
+    expect_erase(c, 0, 10);
+    EXPECT_TRUE(c.empty());
+    c.push_back(1);
+    c.push_front(0);
+    expect_eq(c, {0, 1});
+}
+
+TEST(range_erase, front)
+{
+    counted::no_new_instances_guard g;
+
+    container c = wrapped_deque();
+    expect_erase(c, 0, 3);
+    expect_eq(c, {-1, 0, 1, 2, 3, 4, 5});
+    expect_erase(c, 0, 5);
+    expect_eq(c, {4, 5});
+}
+
+TEST(range_erase, back)
+{
+    counted::no_new_instances_guard g;
+
+    container c = wrapped_deque();
+    expect_erase(c, 7, 10);
+    expect_eq(c, {-4, -3, -2, -1, 0, 1, 2});
+    expect_erase(c, 1, 7);
+    expect_eq(c, {-4});
+}
+
+TEST(range_erase, middle_wrapped)
+{
+    counted::no_new_instances_guard g;
+
+    container c = wrapped_deque();
+    expect_erase(c, 2, 6);
+    expect_eq(c, {-4, -3, 2, 3, 4, 5});
+}
+
+TEST(range_erase, all_ranges)
+{
+    counted::no_new_instances_guard g;
+
+    for (size_t from = 0; from <= 10; ++from)
+        for (size_t to = from; to <= 10; ++to)
+        {
+            container c = wrapped_deque();
+            expect_erase(c, from, to);
+            c.push_front(100);
+            c.push_back(101);
+            EXPECT_EQ(12 - (to - from), c.size());
+        }
+}
@@ -8,6 +8,9 @@
 #include <iterator>
 #include <cassert>
 #include <algorithm>
+#include <functional>
+
+#include "ring_spans.h"
 
 template <typename T>
 struct deque {
@@ -68,13 +71,16 @@ public:
 
     iterator insert(const_iterator pos, T const& val);
     iterator erase(const_iterator pos);
-    //iterator erase(const_iterator first, const_iterator last);
+    iterator erase(const_iterator first, const_iterator last);
 
     void swap(deque<T>& other);
 
     T& operator[](size_t pos);
     T const& operator[](size_t pos) const;
 
+    ring_spans<T> as_spans();
+    ring_spans<T const> as_spans() const;
+
 private:
     void expand(size_t n);
     ptrdiff_t dist(const_iterator a, const_iterator b) const;
@@ -421,21 +427,34 @@ typename deque<T>::iterator deque<T>::insert(const_iterator pos, const T& val) {
 
 template<typename T>
 typename deque<T>::iterator deque<T>::erase(const_iterator pos) {
-    size_t ind = dist(pos, begin());
-    iterator ptr = iterator((begin() + ind)._ptr, _data, _data + _cap, _head);
+    return erase(pos, pos + 1);
+}
 
-    if (dist(pos, begin()) <= dist(pos, end())) {
-        for (; ptr != begin(); ptr--) {
-            std::swap(*ptr, *(ptr - 1));
-        }
-        pop_front();
-    } else {
-        for (; ptr != end() - 1; ptr++) {
-            std::swap(*ptr, *(ptr + 1));
+template<typename T>
+typename deque<T>::iterator deque<T>::erase(const_iterator first, const_iterator last) {
+    size_t from = dist(first, begin());
+    size_t to = dist(last, begin());
+    size_t count = to - from;
+    size_t n = size();
+
+    if (count != 0) {
+        if (from <= n - to) {
+            for (size_t i = from; i > 0; i--) {
+                (*this)[i - 1 + count] = std::move((*this)[i - 1]);
+            }
+            for (size_t i = 0; i < count; i++) {
+                pop_front();
+            }
+        } else {
+            for (size_t i = to; i < n; i++) {
+                (*this)[i - count] = std::move((*this)[i]);
+            }
+            for (size_t i = 0; i < count; i++) {
+                pop_back();
+            }
         }
-        pop_back();
     }
-    return iterator((begin() + ind)._ptr, _data, _data + _cap, _head);
+    return iterator((begin() + from)._ptr, _data, _data + _cap, _head);
 }
 
 template<typename T>
@@ -470,6 +489,16 @@ T const& deque<T>::operator[](size_t pos) const {
     return *res;
 }
 
+template<typename T>
+ring_spans<T> deque<T>::as_spans() {
+    return make_ring_spans(_data, _cap, _head - _data, size());
+}
+
+template<typename T>
+ring_spans<T const> deque<T>::as_spans() const {
+    return make_ring_spans<T const>(_data, _cap, _head - _data, size());
+}
+
 template <typename T>
 void deque<T>::my_copy(T* first, T* last, T* dst) {
     size_t i = 0;
@@ -535,4 +564,195 @@ void deque<T>::finalize(T* data, size_t len) {
     operator delete(data);
 }
 
+// Double-ended priority queue: a min-max heap (Atkinson et al.) laid out in a deque, so it grows
+// the same way. Even levels of the tree are min levels and odd ones are max levels: every node is
+// no greater (resp. no less) than all of its descendants, which puts the minimum at the root and the
+// maximum at one of its two children.
+template <typename T, typename Compare = std::less<T>>
+struct min_max_heap {
+    explicit min_max_heap(Compare const& comp = Compare());
+
+    bool empty() const;
+    size_t size() const;
+
+    void push(T const& val);
+
+    T const& min() const;
+    T const& max() const;
+
+    void pop_min();
+    void pop_max();
+
+    void clear();
+    void swap(min_max_heap& other);
+
+private:
+    static bool on_min_level(size_t i);
+    size_t max_index() const;
+
+    // a goes before b on the given kind of level
+    bool before(size_t a, size_t b, bool min_level) const;
+    void bubble_up(size_t i);
+    void bubble_up_grandparents(size_t i, bool min_level);
+    void trickle_down(size_t i);
+    void remove(size_t i);
+
+    deque<T> _heap;
+    Compare _comp;
+};
+
+template <typename T, typename Compare>
+min_max_heap<T, Compare>::min_max_heap(Compare const& comp)
+        : _comp(comp) {}
+
+template <typename T, typename Compare>
+bool min_max_heap<T, Compare>::empty() const {
+    return _heap.size() == 0;
+}
+
+template <typename T, typename Compare>
+size_t min_max_heap<T, Compare>::size() const {
+    return _heap.size();
+}
+
+template <typename T, typename Compare>
+void min_max_heap<T, Compare>::push(T const& val) {
+    _heap.push_back(val);
+    bubble_up(_heap.size() - 1);
+}
+
+template <typename T, typename Compare>
+T const& min_max_heap<T, Compare>::min() const {
+    assert(!empty());
+    return _heap[0];
+}
+
+template <typename T, typename Compare>
+T const& min_max_heap<T, Compare>::max() const {
+    assert(!empty());
+    return _heap[max_index()];
+}
+
+template <typename T, typename Compare>
+void min_max_heap<T, Compare>::pop_min() {
+    assert(!empty());
+    remove(0);
+}
+
+template <typename T, typename Compare>
+void min_max_heap<T, Compare>::pop_max() {
+    assert(!empty());
+    remove(max_index());
+}
+
+template <typename T, typename Compare>
+void min_max_heap<T, Compare>::clear() {
+    _heap.clear();
+}
+
+template <typename T, typename Compare>
+void min_max_heap<T, Compare>::swap(min_max_heap& other) {
+    _heap.swap(other._heap);
+    std::swap(_comp, other._comp);
+}
+
+template <typename T, typename Compare>
+bool min_max_heap<T, Compare>::on_min_level(size_t i) {
+    size_t level = 0;
+    for (i++; i > 1; i >>= 1) {
+        level++;
+    }
+    return level % 2 == 0;
+}
+
+template <typename T, typename Compare>
+size_t min_max_heap<T, Compare>::max_index() const {
+    if (_heap.size() < 3) {
+        return _heap.size() - 1;
+    }
+    return _comp(_heap[1], _heap[2]) ? 2 : 1;
+}
+
+template <typename T, typename Compare>
+bool min_max_heap<T, Compare>::before(size_t a, size_t b, bool min_level) const {
+    return min_level ? _comp(_heap[a], _heap[b]) : _comp(_heap[b], _heap[a]);
+}
+
+template <typename T, typename Compare>
+void min_max_heap<T, Compare>::bubble_up(size_t i) {
+    if (i == 0) {
+        return;
+    }
+    bool min_level = on_min_level(i);
+    size_t parent = (i - 1) / 2;
+    // a new element that belongs on the other kind of level first swaps with its parent
+    if (before(parent, i, min_level)) {
+        std::swap(_heap[i], _heap[parent]);
+        bubble_up_grandparents(parent, !min_level);
+    } else {
+        bubble_up_grandparents(i, min_level);
+    }
+}
+
+template <typename T, typename Compare>
+void min_max_heap<T, Compare>::bubble_up_grandparents(size_t i, bool min_level) {
+    while (i > 2) {
+        size_t grandparent = ((i - 1) / 2 - 1) / 2;
+        if (!before(i, grandparent, min_level)) {
+            break;
+        }
+        std::swap(_heap[i], _heap[grandparent]);
+        i = grandparent;
+    }
+}
+
+template <typename T, typename Compare>
+void min_max_heap<T, Compare>::trickle_down(size_t i) {
+    bool min_level = on_min_level(i);
+    size_t n = _heap.size();
+    for (;;) {
+        size_t first_child = 2 * i + 1;
+        if (first_child >= n) {
+            return;
+        }
+        // the extreme of up to two children and four grandchildren
+        size_t m = first_child;
+        size_t candidates[] = {first_child + 1, 4 * i + 3, 4 * i + 4, 4 * i + 5, 4 * i + 6};
+        for (size_t c : candidates) {
+            if (c < n && before(c, m, min_level)) {
+                m = c;
+            }
+        }
+        if (!before(m, i, min_level)) {
+            return;
+        }
+        std::swap(_heap[m], _heap[i]);
+        if (m <= first_child + 1) {
+            return;
+        }
+        size_t parent = (m - 1) / 2;
+        if (before(parent, m, min_level)) {
+            std::swap(_heap[m], _heap[parent]);
+        }
+        i = m;
+    }
+}
+
+template <typename T, typename Compare>
+void min_max_heap<T, Compare>::remove(size_t i) {
+    size_t last = _heap.size() - 1;
+    if (i != last) {
+        _heap[i] = std::move(_heap[last]);
+    }
+    _heap.pop_back();
+    if (i != last) {
+        trickle_down(i);
+    }
+}
+
+template <typename T, typename Compare>
+void swap(min_max_heap<T, Compare>& a, min_max_heap<T, Compare>& b) {
+    a.swap(b);
+}
+
 #endif //MY_DEQUE_DEQUE_H
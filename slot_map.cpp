@@ -0,0 +1,180 @@
+#include "slot_map.h"
+#include "fault_injection.h"
+#include <counted.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace
+{
+    template <typename M>
+    std::vector<int> contents(M const& m)
+    {
+        fault_injection_disable dg;
+        return std::vector<int>(m.begin(), m.end());
+    }
+}
+
+TEST(slot_map, insert_find)
+{
+    counted::no_new_instances_guard g;
+
+    slot_map<counted> m;
+    EXPECT_TRUE(m.empty());
+    auto a = m.insert(1);
+    auto b = m.insert(2);
+    auto c = m.insert(3);
+    EXPECT_EQ(3u, m.size());
+    EXPECT_EQ(1, m[a]);
+    EXPECT_EQ(2, m[b]);
+    EXPECT_EQ(3, *m.find(c));
+    EXPECT_EQ((std::vector<int>{1, 2, 3}), contents(m));
+    for (size_t i = 0; i != m.size(); ++i)
+        EXPECT_EQ(m.begin() + i, m.find(m.handle_at(i)));
+}
+
+TEST(slot_map, stale_handle_after_erase)
+{
+    counted::no_new_instances_guard g;
+
+    slot_map<counted> m;
+    auto a = m.insert(1);
+    auto b = m.insert(2);
+    auto c = m.insert(3);
+
+    EXPECT_TRUE(m.erase(a));
+    EXPECT_FALSE(m.contains(a));
+    EXPECT_EQ(nullptr, m.find(a));
+    EXPECT_FALSE(m.erase(a));
+
+    // the last value moved into the hole, its handle follows it
+    EXPECT_EQ((std::vector<int>{3, 2}), contents(m));
+    EXPECT_EQ(2, m[b]);
+    EXPECT_EQ(3, m[c]);
+
+    // reusing the slot does not bring the old handle back
+    auto d = m.insert(4);
+    EXPECT_EQ(a.index, d.index);
+    EXPECT_NE(a, d);
+    EXPECT_FALSE(m.contains(a));
+    EXPECT_EQ(4, m[d]);
+    EXPECT_FALSE(m.erase(a));
+    EXPECT_EQ(3u, m.size());
+}
+
+TEST(slot_map, free_list_reuse)
+{
+    counted::no_new_instances_guard g;
+
+    slot_map<counted> m;
+    std::vector<slot_map<counted>::handle> hs;
+    for (int i = 0; i != 5; ++i)
+        hs.push_back(m.insert(i));
+
+    m.erase(hs[3]);
+    m.erase(hs[1]);
+
+    // freed slots come back oldest first, then fresh ones are appended
+    auto a = m.insert(10);
+    auto b = m.insert(11);
+    auto c = m.insert(12);
+    EXPECT_EQ(3u, a.index);
+    EXPECT_EQ(hs[3].generation + 1, a.generation);
+    EXPECT_EQ(1u, b.index);
+    EXPECT_EQ(hs[1].generation + 1, b.generation);
+    EXPECT_EQ(5u, c.index);
+    EXPECT_EQ(0u, c.generation);
+
+    EXPECT_EQ(10, m[a]);
+    EXPECT_EQ(11, m[b]);
+    EXPECT_EQ(12, m[c]);
+    EXPECT_EQ(6u, m.size());
+}
+
+TEST(slot_map, generation_wraparound)
+{
+    counted::no_new_instances_guard g;
+
+    slot_map<counted, uint8_t> m;
+    std::vector<slot_map<counted, uint8_t>::handle> old;
+    for (int i = 0; i != 256; ++i)
+    {
+        auto h = m.insert(i);
+        ASSERT_EQ(0u, h.index);
+        ASSERT_EQ(i, h.generation);
+        old.push_back(h);
+        ASSERT_TRUE(m.erase(h));
+    }
+
+    // the slot ran out of generations and is retired instead of wrapping back to 0
+    auto h = m.insert(1000);
+    EXPECT_EQ(1u, h.index);
+    EXPECT_EQ(0u, h.generation);
+    for (auto const& o : old)
+        EXPECT_FALSE(m.contains(o));
+    EXPECT_EQ(1000, m[h]);
+}
+
+TEST(slot_map, clear)
+{
+    counted::no_new_instances_guard g;
+
+    slot_map<counted> m;
+    auto a = m.insert(1);
+    auto b = m.insert(2);
+    m.clear();
+    EXPECT_TRUE(m.empty());
+    EXPECT_FALSE(m.contains(a));
+    EXPECT_FALSE(m.contains(b));
+    g.expect_no_instances();
+
+    auto c = m.insert(3);
+    EXPECT_EQ(3, m[c]);
+    EXPECT_EQ(1u, m.size());
+}
+
+TEST(slot_map, swap)
+{
+    counted::no_new_instances_guard g;
+
+    slot_map<counted> m1, m2;
+    auto a = m1.insert(1);
+    auto b = m2.insert(2);
+    m2.erase(b);
+    swap(m1, m2);
+    EXPECT_TRUE(m1.empty());
+    EXPECT_EQ(1, m2[a]);
+    EXPECT_EQ(b.index, m1.insert(3).index);
+}
+
+TEST(slot_map, fault_injection_insert)
+{
+    faulty_run([]
+    {
+        slot_map<counted> m;
+        slot_map<counted>::handle b;
+        {
+            // erase swallows a failure to queue the freed slot, which faulty_run would not expect
+            fault_injection_disable dg;
+            auto a = m.insert(1);
+            b = m.insert(2);
+            m.erase(a);
+        }
+
+        try
+        {
+            m.insert(3);
+        }
+        catch (...)
+        {
+            fault_injection_disable dg;
+            EXPECT_EQ((std::vector<int>{2}), contents(m));
+            EXPECT_EQ(2, m[b]);
+            throw;
+        }
+
+        fault_injection_disable dg;
+        EXPECT_EQ((std::vector<int>{2, 3}), contents(m));
+        EXPECT_EQ(2, m[b]);
+    });
+}
@@ -0,0 +1,190 @@
+#ifndef SLOT_MAP_H
+#define SLOT_MAP_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fedorova_irina.h"
+
+// Unordered container addressed by handles that survive any number of other inserts and erases.
+// Values are kept densely packed (erase moves the last value into the hole), so iteration is a plain
+// array walk; slots map a handle to the current position of its value. Every erase bumps the slot's
+// generation, which makes the old handle stale instead of dangling.
+// Freed slots queue up in a my::circular_buffer and are reused oldest first, so a slot goes through
+// all the others before its generation advances again. A slot whose generation would wrap is retired,
+// as is one that could not be queued because the free list failed to grow. A narrower Generation makes
+// handles smaller at the cost of retiring slots sooner.
+template<typename T, typename Generation = uint32_t>
+struct slot_map {
+    static_assert(std::is_unsigned<Generation>::value, "Generation must be an unsigned integer type");
+
+    struct handle {
+        uint32_t index;
+        Generation generation;
+
+        friend bool operator==(handle a, handle b) {
+            return a.index == b.index && a.generation == b.generation;
+        }
+
+        friend bool operator!=(handle a, handle b) {
+            return !(a == b);
+        }
+    };
+
+    using iterator = T *;
+    using const_iterator = T const *;
+
+    size_t size() const noexcept {
+        return values.size();
+    }
+
+    bool empty() const noexcept {
+        return values.empty();
+    }
+
+    bool contains(handle h) const noexcept {
+        return h.index < slots.size() && slots[h.index].generation == h.generation && slots[h.index].live;
+    }
+
+    // nullptr for a stale handle
+    T *find(handle h) noexcept {
+        return contains(h) ? &values[slots[h.index].dense] : nullptr;
+    }
+
+    T const *find(handle h) const noexcept {
+        return contains(h) ? &values[slots[h.index].dense] : nullptr;
+    }
+
+    T &operator[](handle h) {
+        assert(contains(h));
+        return values[slots[h.index].dense];
+    }
+
+    T const &operator[](handle h) const {
+        assert(contains(h));
+        return values[slots[h.index].dense];
+    }
+
+    handle insert(T const &val) {
+        bool fresh = free_slots.empty();
+        if (fresh) {
+            assert(slots.size() < std::numeric_limits<uint32_t>::max());
+            slots.push_back(slot{0, 0, false});
+        }
+        uint32_t index = fresh ? uint32_t(slots.size() - 1) : free_slots.front();
+        try {
+            values.push_back(val);
+            try {
+                owners.push_back(index);
+            } catch (...) {
+                values.pop_back();
+                throw;
+            }
+        } catch (...) {
+            if (fresh) {
+                slots.pop_back();
+            }
+            throw;
+        }
+        if (!fresh) {
+            free_slots.pop_front();
+        }
+        slot &s = slots[index];
+        s.dense = values.size() - 1;
+        s.live = true;
+        return handle{index, s.generation};
+    }
+
+    // false if h is stale
+    bool erase(handle h) {
+        if (!contains(h)) {
+            return false;
+        }
+        size_t pos = slots[h.index].dense;
+        size_t last = values.size() - 1;
+        if (pos != last) {
+            values[pos] = std::move(values[last]);
+            owners[pos] = owners[last];
+            slots[owners[pos]].dense = pos;
+        }
+        values.pop_back();
+        owners.pop_back();
+        release(h.index);
+        return true;
+    }
+
+    void clear() {
+        for (uint32_t index : owners) {
+            release(index);
+        }
+        values.clear();
+        owners.clear();
+    }
+
+    // the handle of the value at position pos of the iteration order
+    handle handle_at(size_t pos) const noexcept {
+        uint32_t index = owners[pos];
+        return handle{index, slots[index].generation};
+    }
+
+    iterator begin() noexcept {
+        return values.data();
+    }
+
+    iterator end() noexcept {
+        return values.data() + values.size();
+    }
+
+    const_iterator begin() const noexcept {
+        return values.data();
+    }
+
+    const_iterator end() const noexcept {
+        return values.data() + values.size();
+    }
+
+    void swap(slot_map &other) noexcept {
+        values.swap(other.values);
+        owners.swap(other.owners);
+        slots.swap(other.slots);
+        my::swap(free_slots, other.free_slots);
+    }
+
+private:
+    struct slot {
+        size_t dense;
+        Generation generation;
+        bool live;
+    };
+
+    void release(uint32_t index) noexcept {
+        slot &s = slots[index];
+        s.live = false;
+        if (s.generation == std::numeric_limits<Generation>::max()) {
+            return;
+        }
+        ++s.generation;
+        try {
+            free_slots.push_back(index);
+        } catch (...) {
+            // the value is gone either way, the slot just won't be reused
+        }
+    }
+
+    std::vector<T> values;
+    std::vector<uint32_t> owners;
+    std::vector<slot> slots;
+    my::circular_buffer<uint32_t> free_slots;
+};
+
+template<typename T, typename Generation>
+void swap(slot_map<T, Generation> &a, slot_map<T, Generation> &b) noexcept {
+    a.swap(b);
+}
+
+#endif //SLOT_MAP_H
@@ -3,3 +3,299 @@
 using container = circular_buffer<counted>;
 
 #include "tests.inl"
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    // a fresh file name under gtest's temporary directory, removed again on scope exit
+    struct temp_path
+    {
+        explicit temp_path(std::string const& name)
+            : path(testing::TempDir() + "smirnov_roman_" + name + "_" + std::to_string(getpid()))
+        {
+            unlink(path.c_str());
+        }
+
+        ~temp_path()
+        {
+            unlink(path.c_str());
+        }
+
+        std::string path;
+    };
+
+    template <typename T>
+    std::vector<T> persistent_contents(persistent_circular_buffer<T> const& c)
+    {
+        std::vector<T> res;
+        for (size_t i = 0; i != c.size(); ++i)
+            res.push_back(c[i]);
+        return res;
+    }
+}
+
+TEST(persistent, reopen_resumes)
+{
+    temp_path tmp("reopen");
+    {
+        persistent_circular_buffer<int> c(tmp.path, 4);
+        EXPECT_TRUE(c.empty());
+        for (int i = 0; i != 3; ++i)
+            c.push_back(i);
+        c.push_front(-1);
+        c.sync();
+    }
+    {
+        persistent_circular_buffer<int> c(tmp.path);
+        EXPECT_EQ((std::vector<int>{-1, 0, 1, 2}), persistent_contents(c));
+        c.pop_front();
+        c.push_back(3);
+    }
+    persistent_circular_buffer<int> c(tmp.path);
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3}), persistent_contents(c));
+    EXPECT_EQ(0, c.front());
+    EXPECT_EQ(3, c.back());
+}
+
+TEST(persistent, resume_after_wrap_and_growth)
+{
+    temp_path tmp("wrap");
+    std::vector<long> expected;
+    {
+        persistent_circular_buffer<long> c(tmp.path, 4);
+        // wrap the ring, then grow it while it is wrapped
+        for (long i = 0; i != 4; ++i)
+            c.push_back(i);
+        c.pop_front();
+        c.pop_front();
+        c.push_back(4);
+        c.push_back(5);
+        for (long i = 6; i != 40; ++i)
+            c.push_back(i);
+        c.push_front(1);
+        EXPECT_LT(4u, c.capacity());
+        expected = persistent_contents(c);
+    }
+    for (int round = 0; round != 3; ++round)
+    {
+        persistent_circular_buffer<long> c(tmp.path);
+        ASSERT_EQ(expected, persistent_contents(c));
+        c.pop_front();
+        c.push_back(100 + round);
+        expected.erase(expected.begin());
+        expected.push_back(100 + round);
+
+        ring_spans<long const> spans = static_cast<persistent_circular_buffer<long> const&>(c).as_spans();
+        EXPECT_EQ(expected.size(), spans.size());
+    }
+}
+
+TEST(persistent, clear_persists)
+{
+    temp_path tmp("clear");
+    {
+        persistent_circular_buffer<int> c(tmp.path);
+        c.push_back(1);
+        c.clear();
+    }
+    persistent_circular_buffer<int> c(tmp.path);
+    EXPECT_TRUE(c.empty());
+}
+
+TEST(persistent, rejects_foreign_files)
+{
+    temp_path tmp("foreign");
+    {
+        persistent_circular_buffer<int> c(tmp.path);
+        c.push_back(1);
+    }
+    // different element type
+    EXPECT_THROW(persistent_circular_buffer<long>(tmp.path), std::runtime_error);
+
+    // not a buffer at all
+    {
+        std::ofstream f(tmp.path, std::ios::trunc);
+        f << "this is not a persistent_circular_buffer file, just some text long enough to hold a header";
+    }
+    EXPECT_THROW(persistent_circular_buffer<int>(tmp.path), std::runtime_error);
+
+    // shorter than a header
+    {
+        std::ofstream f(tmp.path, std::ios::trunc);
+        f << "short";
+    }
+    EXPECT_THROW(persistent_circular_buffer<int>(tmp.path), std::runtime_error);
+}
+
+TEST(persistent, position_is_one_word)
+{
+    temp_path tmp("position");
+    {
+        persistent_circular_buffer<int> c(tmp.path, 4);
+        mass_push_back(c, {1, 2});
+        c.push_front(0);
+    }
+    // head 3 and size 3 live in the single word after magic, version and element_size
+    std::ifstream f(tmp.path, std::ios::binary);
+    f.seekg(16);
+    uint64_t position = 0;
+    f.read(reinterpret_cast<char*>(&position), sizeof(position));
+    EXPECT_EQ(uint64_t(3) << 32 | 3, position);
+}
+
+TEST(persistent, rejects_inconsistent_position)
+{
+    temp_path tmp("inconsistent");
+    {
+        persistent_circular_buffer<int> c(tmp.path, 4);
+        c.push_back(1);
+    }
+    {
+        std::fstream f(tmp.path, std::ios::binary | std::ios::in | std::ios::out);
+        f.seekp(16);
+        uint64_t position = uint64_t(5) << 32; // size 5 > capacity 4
+        f.write(reinterpret_cast<char const*>(&position), sizeof(position));
+    }
+    EXPECT_THROW(persistent_circular_buffer<int>(tmp.path), std::runtime_error);
+}
+
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <thread>
+
+TEST(blocking_queue, fifo)
+{
+    blocking_queue<int> q(4);
+    EXPECT_EQ(4u, q.capacity());
+    for (int i = 0; i != 4; ++i)
+        EXPECT_TRUE(q.push(i));
+    EXPECT_EQ(4u, q.size());
+
+    int out;
+    ASSERT_TRUE(q.pop(out));
+    EXPECT_EQ(0, out);
+    EXPECT_TRUE(q.push(4));
+
+    std::vector<int> batch;
+    EXPECT_EQ(2u, q.pop_up_to(2, std::back_inserter(batch)));
+    EXPECT_EQ((std::vector<int>{1, 2}), batch);
+    EXPECT_EQ(2u, q.pop_all(std::back_inserter(batch)));
+    EXPECT_EQ((std::vector<int>{1, 2, 3, 4}), batch);
+    EXPECT_EQ(0u, q.size());
+}
+
+TEST(blocking_queue, close_drains_then_fails)
+{
+    blocking_queue<int> q(4);
+    q.push(1);
+    q.push(2);
+    q.close();
+    EXPECT_FALSE(q.push(3));
+
+    int out;
+    ASSERT_TRUE(q.pop(out));
+    EXPECT_EQ(1, out);
+    std::vector<int> rest;
+    EXPECT_EQ(1u, q.pop_up_to(8, std::back_inserter(rest)));
+    EXPECT_EQ((std::vector<int>{2}), rest);
+    EXPECT_FALSE(q.pop(out));
+    EXPECT_EQ(0u, q.pop_up_to(8, std::back_inserter(rest)));
+    EXPECT_EQ(0u, q.pop_all(std::back_inserter(rest)));
+}
+
+TEST(blocking_queue, close_wakes_blocked_threads)
+{
+    blocking_queue<int> empty(2), full(1);
+    full.push(0);
+
+    std::atomic<int> failed(0);
+    std::vector<std::thread> ts;
+    for (int i = 0; i != 3; ++i)
+    {
+        ts.emplace_back([&]
+        {
+            int out;
+            if (!empty.pop(out))
+                ++failed;
+        });
+        ts.emplace_back([&]
+        {
+            if (!full.push(1))
+                ++failed;
+        });
+    }
+    // whether or not the threads are blocked yet, close must get every one of them out
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    empty.close();
+    full.close();
+    for (std::thread& t : ts)
+        t.join();
+    EXPECT_EQ(6, failed);
+    EXPECT_EQ(1u, full.size());
+}
+
+TEST(blocking_queue, producers_consumers)
+{
+    size_t const producers = 4, consumers = 3, per_producer = 50000;
+    // a small batch keeps the coalesced wakeups busy
+    blocking_queue<size_t> q(16, 4);
+    std::atomic<size_t> sum(0), count(0);
+    std::atomic<bool> ordered(true);
+
+    std::vector<std::thread> cs;
+    for (size_t c = 0; c != consumers; ++c)
+        cs.emplace_back([&, c]
+        {
+            std::vector<size_t> last(producers, 0);
+            std::vector<bool> seen(producers, false);
+            auto take = [&](size_t val)
+            {
+                size_t p = val / per_producer;
+                if (seen[p] && val <= last[p])
+                    ordered = false;
+                seen[p] = true;
+                last[p] = val;
+                sum += val;
+                ++count;
+            };
+            std::vector<size_t> batch;
+            size_t val;
+            // one consumer pops in batches, the others one by one
+            if (c == 0)
+            {
+                while (q.pop_up_to(7, std::back_inserter(batch)))
+                {
+                    for (size_t v : batch)
+                        take(v);
+                    batch.clear();
+                }
+            }
+            else
+            {
+                while (q.pop(val))
+                    take(val);
+            }
+        });
+
+    std::vector<std::thread> ps;
+    for (size_t p = 0; p != producers; ++p)
+        ps.emplace_back([&q, p]
+        {
+            for (size_t i = 0; i != per_producer; ++i)
+                q.push(p * per_producer + i);
+        });
+    for (std::thread& t : ps)
+        t.join();
+    q.close();
+    for (std::thread& t : cs)
+        t.join();
+
+    size_t n = producers * per_producer;
+    EXPECT_EQ(n, count);
+    EXPECT_EQ(n * (n - 1) / 2, sum);
+    EXPECT_TRUE(ordered);
+}
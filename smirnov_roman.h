@@ -6,7 +6,24 @@
 #define EXAM_CIRCULAR_BUFFER_H
 
 #include <iterator>
+#include <atomic>
+#include <condition_variable>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ring_spans.h"
 
 template<typename T>
 struct circular_buffer
@@ -366,6 +383,15 @@ public:
         return size_t(_size) ;
     }
 
+    ring_spans<T> as_spans()
+    {
+        return make_ring_spans(buffer_start, buffer_size, begin_shift, _size);
+    }
+    ring_spans<const T> as_spans() const
+    {
+        return make_ring_spans<const T>(buffer_start, buffer_size, begin_shift, _size);
+    }
+
     const_reverse_iterator rbegin() const
     {
         return const_reverse_iterator(end());
@@ -418,4 +444,681 @@ void swap(circular_buffer<T> &a, circular_buffer<T> &b)
     a.swap(b);
 }
 
+// Bounded producer/consumer queue over a preallocated circular_buffer.
+// Wakeups are coalesced: a push signals a consumer only when it makes the queue non-empty or when
+// notify_batch items have been pushed since the last signal, and a woken consumer passes the signal on
+// if it leaves items behind, so a busy stream costs one futex wake per batch instead of one per item.
+// pop_up_to/pop_all take everything they return under a single lock acquisition.
+template<typename T>
+struct blocking_queue
+{
+    explicit blocking_queue(size_t max_size, size_t notify_batch = 64)
+        : items(ptrdiff_t(max_size)), max_size(max_size), notify_batch(notify_batch ? notify_batch : 1),
+          unsignaled(0), waiting_consumers(0), waiting_producers(0), closed(false)
+    {}
+
+    blocking_queue(const blocking_queue &) = delete;
+    blocking_queue &operator=(const blocking_queue &) = delete;
+
+    // blocks while the queue is full, false if it has been closed
+    bool push(T item)
+    {
+        std::unique_lock<std::mutex> lock(m);
+        while (items.size() == max_size && !closed) {
+            wait(not_full, lock, waiting_producers);
+        }
+        if (closed) {
+            return false;
+        }
+        items.push_back(std::move(item));
+        bool signal = waiting_consumers != 0 && (items.size() == 1 || ++unsignaled >= notify_batch);
+        bool pass_on = waiting_producers != 0 && items.size() < max_size;
+        if (signal) {
+            unsignaled = 0;
+        }
+        lock.unlock();
+        if (signal) {
+            not_empty.notify_one();
+        }
+        if (pass_on) {
+            not_full.notify_one();
+        }
+        return true;
+    }
+
+    // blocks while the queue is empty, false once it is closed and drained
+    bool pop(T &out)
+    {
+        std::unique_lock<std::mutex> lock(m);
+        if (!wait_for_items(lock)) {
+            return false;
+        }
+        out = std::move(items.front());
+        items.pop_front();
+        wake_after_pop(lock, 1);
+        return true;
+    }
+
+    // blocks while the queue is empty, then moves up to n items to out;
+    // returns how many, 0 only once the queue is closed and drained
+    template<typename OutputIt>
+    size_t pop_up_to(size_t n, OutputIt out)
+    {
+        std::unique_lock<std::mutex> lock(m);
+        if (!wait_for_items(lock)) {
+            return 0;
+        }
+        size_t count = items.size() < n ? items.size() : n;
+        for (size_t i = 0; i != count; ++i, ++out) {
+            *out = std::move(items.front());
+            items.pop_front();
+        }
+        wake_after_pop(lock, count);
+        return count;
+    }
+
+    template<typename OutputIt>
+    size_t pop_all(OutputIt out)
+    {
+        return pop_up_to(max_size, out);
+    }
+
+    // wakes everybody; pushes fail from now on, pops drain what is left
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lg(m);
+            closed = true;
+        }
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lg(m);
+        return items.size();
+    }
+
+    size_t capacity() const
+    {
+        return max_size;
+    }
+
+private:
+    static void wait(std::condition_variable &cv, std::unique_lock<std::mutex> &lock, size_t &waiting)
+    {
+        ++waiting;
+        cv.wait(lock);
+        --waiting;
+    }
+
+    bool wait_for_items(std::unique_lock<std::mutex> &lock)
+    {
+        while (items.empty() && !closed) {
+            wait(not_empty, lock, waiting_consumers);
+        }
+        return !items.empty();
+    }
+
+    // called with the lock held after count items were taken, releases it
+    void wake_after_pop(std::unique_lock<std::mutex> &lock, size_t count)
+    {
+        // one producer is enough, it passes the signal on while there is room
+        bool producers = waiting_producers != 0 && items.size() + count == max_size;
+        bool pass_on = waiting_consumers != 0 && !items.empty();
+        if (pass_on) {
+            unsignaled = 0;
+        }
+        lock.unlock();
+        if (producers) {
+            not_full.notify_one();
+        }
+        if (pass_on) {
+            not_empty.notify_one();
+        }
+    }
+
+    mutable std::mutex m;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    circular_buffer<T> items;
+    size_t max_size;
+    size_t notify_batch;
+    size_t unsignaled;
+    size_t waiting_consumers;
+    size_t waiting_producers;
+    bool closed;
+};
+
+// One memfd mapped twice back to back: byte i and byte i + size() are the same memory,
+// so any window of up to size() bytes starting inside the first copy is contiguous.
+struct mirrored_memory
+{
+    mirrored_memory() noexcept
+        : start(nullptr), bytes(0)
+    {}
+
+    // at least min_bytes, rounded up to whole pages and to a multiple of granularity
+    mirrored_memory(size_t min_bytes, size_t granularity)
+        : start(nullptr), bytes(0)
+    {
+        size_t page = size_t(sysconf(_SC_PAGESIZE));
+        size_t step = page;
+        while (step % granularity != 0) {
+            step += page;
+        }
+        size_t size = step;
+        while (size < min_bytes) {
+            size += step;
+        }
+
+        int fd = memfd_create("mirrored_circular_buffer", MFD_CLOEXEC);
+        if (fd == -1) {
+            throw std::bad_alloc();
+        }
+        if (ftruncate(fd, off_t(size)) != 0) {
+            close(fd);
+            throw std::bad_alloc();
+        }
+        void *reserved = mmap(nullptr, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (reserved == MAP_FAILED) {
+            close(fd);
+            throw std::bad_alloc();
+        }
+        char *first = static_cast<char *>(reserved);
+        bool mapped = mmap(first, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED
+            && mmap(first + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+        // the mappings keep the file alive
+        close(fd);
+        if (!mapped) {
+            munmap(reserved, 2 * size);
+            throw std::bad_alloc();
+        }
+        start = first;
+        bytes = size;
+    }
+
+    mirrored_memory(const mirrored_memory &) = delete;
+    mirrored_memory &operator=(const mirrored_memory &) = delete;
+
+    ~mirrored_memory()
+    {
+        if (start) {
+            munmap(start, 2 * bytes);
+        }
+    }
+
+    void swap(mirrored_memory &other) noexcept
+    {
+        std::swap(start, other.start);
+        std::swap(bytes, other.bytes);
+    }
+
+    void *data() const
+    {
+        return start;
+    }
+
+    size_t size() const
+    {
+        return bytes;
+    }
+
+private:
+    char *start;
+    size_t bytes;
+};
+
+// circular_buffer over mirrored_memory: element begin_shift + i is always in the mapping,
+// so operator[] and the (plain pointer) iterators never wrap, and the contents are one contiguous range.
+// Elements are moved around with memcpy, hence trivially copyable T only.
+template<typename T>
+struct mirrored_circular_buffer
+{
+    static_assert(std::is_trivially_copyable<T>::value, "elements are relocated with memcpy");
+
+    typedef T *iterator;
+    typedef const T *const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    mirrored_circular_buffer() noexcept
+        : buffer_start(nullptr), buffer_size(0), begin_shift(0), _size(0)
+    {}
+
+    explicit mirrored_circular_buffer(ptrdiff_t buffer_size)
+        : mirrored_circular_buffer()
+    {
+        reserve(buffer_size);
+    }
+
+    mirrored_circular_buffer(const mirrored_circular_buffer &other)
+        : mirrored_circular_buffer()
+    {
+        if (other._size != 0) {
+            reserve(other._size);
+            std::memcpy(buffer_start, other.begin(), sizeof(T) * other._size);
+            _size = other._size;
+        }
+    }
+
+    mirrored_circular_buffer &operator=(const mirrored_circular_buffer &other)
+    {
+        mirrored_circular_buffer tmp(other);
+        swap(tmp);
+        return *this;
+    }
+
+    void swap(mirrored_circular_buffer &other) noexcept
+    {
+        memory.swap(other.memory);
+        std::swap(buffer_start, other.buffer_start);
+        std::swap(buffer_size, other.buffer_size);
+        std::swap(begin_shift, other.begin_shift);
+        std::swap(_size, other._size);
+    }
+
+    void reserve(ptrdiff_t new_size)
+    {
+        if (new_size <= buffer_size) {
+            return;
+        }
+        mirrored_memory other(sizeof(T) * new_size, sizeof(T));
+        if (_size != 0) {
+            std::memcpy(other.data(), begin(), sizeof(T) * _size);
+        }
+        memory.swap(other);
+        buffer_start = static_cast<T *>(memory.data());
+        buffer_size = ptrdiff_t(memory.size() / sizeof(T));
+        begin_shift = 0;
+    }
+
+    void push_back(T item)
+    {
+        ensure_capacity(_size + 1);
+        buffer_start[begin_shift + _size] = item;
+        _size++;
+    }
+
+    void push_front(T item)
+    {
+        ensure_capacity(_size + 1);
+        begin_shift = (begin_shift == 0 ? buffer_size : begin_shift) - 1;
+        buffer_start[begin_shift] = item;
+        _size++;
+    }
+
+    void pop_back()
+    {
+        _size--;
+    }
+
+    void pop_front()
+    {
+        _size--;
+        if (++begin_shift == buffer_size) {
+            begin_shift = 0;
+        }
+    }
+
+    void clear()
+    {
+        _size = 0;
+        begin_shift = 0;
+    }
+
+    T &operator[](ptrdiff_t pos)
+    {
+        return buffer_start[begin_shift + pos];
+    }
+    const T &operator[](ptrdiff_t pos) const
+    {
+        return buffer_start[begin_shift + pos];
+    }
+
+    T &front()
+    {
+        return (*this)[0];
+    }
+    const T &front() const
+    {
+        return (*this)[0];
+    }
+    T &back()
+    {
+        return (*this)[_size - 1];
+    }
+    const T &back() const
+    {
+        return (*this)[_size - 1];
+    }
+
+    iterator begin()
+    {
+        return buffer_start + begin_shift;
+    }
+    iterator end()
+    {
+        return begin() + _size;
+    }
+    const_iterator begin() const
+    {
+        return buffer_start + begin_shift;
+    }
+    const_iterator end() const
+    {
+        return begin() + _size;
+    }
+
+    reverse_iterator rbegin()
+    {
+        return reverse_iterator(end());
+    }
+    reverse_iterator rend()
+    {
+        return reverse_iterator(begin());
+    }
+    const_reverse_iterator rbegin() const
+    {
+        return const_reverse_iterator(end());
+    }
+    const_reverse_iterator rend() const
+    {
+        return const_reverse_iterator(begin());
+    }
+
+    // the whole contents as one span, array_two is always empty
+    ring_spans<T> as_spans()
+    {
+        return {{begin(), size_t(_size)}, {begin(), 0}};
+    }
+    ring_spans<const T> as_spans() const
+    {
+        return {{begin(), size_t(_size)}, {begin(), 0}};
+    }
+
+    bool empty() const
+    {
+        return _size == 0;
+    }
+    size_t size() const
+    {
+        return size_t(_size);
+    }
+    size_t capacity() const
+    {
+        return size_t(buffer_size);
+    }
+
+private:
+    void ensure_capacity(ptrdiff_t new_size)
+    {
+        if (new_size > buffer_size) {
+            reserve(new_size * 2);
+        }
+    }
+
+    mirrored_memory memory;
+    T *buffer_start;
+    ptrdiff_t buffer_size;
+    ptrdiff_t begin_shift;
+    ptrdiff_t _size;
+};
+
+template<typename T>
+void swap(mirrored_circular_buffer<T> &a, mirrored_circular_buffer<T> &b)
+{
+    a.swap(b);
+}
+
+// Layout of the file behind persistent_circular_buffer: this header, then capacity elements.
+// head and size are packed into one 64-bit word (size in the upper half), so every push and pop
+// publishes its new position with a single aligned store: a process killed at any point leaves
+// either the old or the new position in the file, never the head of one and the size of the other.
+struct persistent_header
+{
+    static const uint64_t MAGIC = 0x7265666675626370; // "pcbuffer"
+    static const uint32_t VERSION = 2;
+    static const uint64_t MAX_CAPACITY = 0xffffffff;
+
+    uint64_t magic;
+    uint32_t version;
+    uint32_t element_size;
+    std::atomic<uint64_t> position;
+    uint64_t capacity;
+
+    uint64_t head() const
+    {
+        return position.load(std::memory_order_relaxed) & MAX_CAPACITY;
+    }
+    uint64_t size() const
+    {
+        return position.load(std::memory_order_relaxed) >> 32;
+    }
+    // the elements are written before the position that makes them visible
+    void set_position(uint64_t new_head, uint64_t new_size)
+    {
+        position.store(new_size << 32 | new_head, std::memory_order_release);
+    }
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the position must be a single store");
+
+// circular_buffer whose storage is an mmap'ed file, so the contents survive the process:
+// opening an existing file resumes in O(1), nothing is parsed or copied.
+// Same indexing as circular_buffer (element i at (head + i) % capacity); the header is
+// updated after the elements it describes. At most persistent_header::MAX_CAPACITY elements,
+// trivially copyable T only.
+template<typename T>
+struct persistent_circular_buffer
+{
+    static_assert(std::is_trivially_copyable<T>::value, "elements are stored as raw bytes");
+
+    // opens path, creating an empty buffer of at least min_capacity elements if the file is empty or missing
+    explicit persistent_circular_buffer(const std::string &path, size_t min_capacity = 16)
+        : fd(-1), map(nullptr), map_bytes(0)
+    {
+        fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd == -1) {
+            throw std::runtime_error("persistent_circular_buffer: cannot open " + path);
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw std::runtime_error("persistent_circular_buffer: cannot stat " + path);
+        }
+        try {
+            if (st.st_size == 0) {
+                if (min_capacity > persistent_header::MAX_CAPACITY) {
+                    throw std::length_error("persistent_circular_buffer: capacity too large");
+                }
+                remap(data_offset() + sizeof(T) * (min_capacity ? min_capacity : 1));
+                header()->element_size = sizeof(T);
+                header()->set_position(0, 0);
+                header()->capacity = min_capacity ? min_capacity : 1;
+                header()->version = persistent_header::VERSION;
+                header()->magic = persistent_header::MAGIC;
+            } else {
+                if (size_t(st.st_size) < data_offset()) {
+                    throw std::runtime_error("persistent_circular_buffer: truncated " + path);
+                }
+                remap(size_t(st.st_size));
+                persistent_header *h = header();
+                if (h->magic != persistent_header::MAGIC || h->version != persistent_header::VERSION
+                    || h->element_size != sizeof(T) || h->capacity > persistent_header::MAX_CAPACITY
+                    || data_offset() + sizeof(T) * h->capacity > map_bytes || h->head() >= h->capacity
+                    || h->size() > h->capacity) {
+                    throw std::runtime_error("persistent_circular_buffer: bad header in " + path);
+                }
+            }
+        } catch (...) {
+            if (map) {
+                munmap(map, map_bytes);
+            }
+            close(fd);
+            throw;
+        }
+    }
+
+    persistent_circular_buffer(const persistent_circular_buffer &) = delete;
+    persistent_circular_buffer &operator=(const persistent_circular_buffer &) = delete;
+
+    ~persistent_circular_buffer()
+    {
+        munmap(map, map_bytes);
+        close(fd);
+    }
+
+    void push_back(T item)
+    {
+        ensure_capacity();
+        persistent_header *h = header();
+        uint64_t head = h->head(), size = h->size();
+        data()[(head + size) % h->capacity] = item;
+        h->set_position(head, size + 1);
+    }
+
+    void push_front(T item)
+    {
+        ensure_capacity();
+        persistent_header *h = header();
+        uint64_t head = h->head();
+        uint64_t new_head = (head == 0 ? h->capacity : head) - 1;
+        data()[new_head] = item;
+        h->set_position(new_head, h->size() + 1);
+    }
+
+    void pop_back()
+    {
+        persistent_header *h = header();
+        h->set_position(h->head(), h->size() - 1);
+    }
+
+    void pop_front()
+    {
+        persistent_header *h = header();
+        h->set_position((h->head() + 1) % h->capacity, h->size() - 1);
+    }
+
+    void clear()
+    {
+        persistent_header *h = header();
+        h->set_position(h->head(), 0);
+    }
+
+    T &operator[](size_t pos)
+    {
+        return data()[(header()->head() + pos) % header()->capacity];
+    }
+    const T &operator[](size_t pos) const
+    {
+        return data()[(header()->head() + pos) % header()->capacity];
+    }
+
+    T &front()
+    {
+        return (*this)[0];
+    }
+    const T &front() const
+    {
+        return (*this)[0];
+    }
+    T &back()
+    {
+        return (*this)[size() - 1];
+    }
+    const T &back() const
+    {
+        return (*this)[size() - 1];
+    }
+
+    ring_spans<T> as_spans()
+    {
+        return make_ring_spans(data(), capacity(), size_t(header()->head()), size());
+    }
+    ring_spans<const T> as_spans() const
+    {
+        return make_ring_spans<const T>(data(), capacity(), size_t(header()->head()), size());
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+    size_t size() const
+    {
+        return size_t(header()->size());
+    }
+    size_t capacity() const
+    {
+        return size_t(header()->capacity);
+    }
+
+    // flush the mapping to the file; without it durability is up to the kernel
+    void sync()
+    {
+        if (msync(map, map_bytes, MS_SYNC) != 0) {
+            throw std::runtime_error("persistent_circular_buffer: msync failed");
+        }
+    }
+
+private:
+    static size_t data_offset()
+    {
+        size_t align = alignof(T) > 64 ? alignof(T) : 64;
+        return (sizeof(persistent_header) + align - 1) / align * align;
+    }
+
+    persistent_header *header() const
+    {
+        return static_cast<persistent_header *>(map);
+    }
+
+    T *data() const
+    {
+        return reinterpret_cast<T *>(static_cast<char *>(map) + data_offset());
+    }
+
+    // resize the file to bytes and map all of it
+    void remap(size_t bytes)
+    {
+        if (ftruncate(fd, off_t(bytes)) != 0) {
+            throw std::bad_alloc();
+        }
+        void *new_map = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (new_map == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        if (map) {
+            munmap(map, map_bytes);
+        }
+        map = new_map;
+        map_bytes = bytes;
+    }
+
+    // doubles the file; a wrapped tail [0, head + size - capacity) is moved right after the old end
+    void ensure_capacity()
+    {
+        persistent_header *h = header();
+        if (h->size() < h->capacity) {
+            return;
+        }
+        uint64_t old_capacity = h->capacity;
+        if (old_capacity > persistent_header::MAX_CAPACITY / 2) {
+            throw std::length_error("persistent_circular_buffer: capacity too large");
+        }
+        remap(data_offset() + sizeof(T) * old_capacity * 2);
+        h = header();
+        uint64_t head = h->head(), size = h->size();
+        uint64_t wrapped = head + size > old_capacity ? head + size - old_capacity : 0;
+        std::memcpy(data() + old_capacity, data(), sizeof(T) * wrapped);
+        h->capacity = old_capacity * 2;
+    }
+
+    int fd;
+    void *map;
+    size_t map_bytes;
+};
+
 #endif //EXAM_CIRCULAR_BUFFER_H
@@ -0,0 +1,150 @@
+#include "smirnov_roman.h"
+#include <gtest/gtest.h>
+
+#include <deque>
+#include <vector>
+
+namespace
+{
+    std::vector<int> contents(mirrored_circular_buffer<int> const& c)
+    {
+        return std::vector<int>(c.begin(), c.end());
+    }
+
+    std::vector<int> iota_vector(int first, int last)
+    {
+        std::vector<int> res;
+        for (int i = first; i != last; ++i)
+            res.push_back(i);
+        return res;
+    }
+}
+
+TEST(mirrored, growth)
+{
+    mirrored_circular_buffer<int> c;
+    EXPECT_EQ(0u, c.capacity());
+    for (int i = 0; i != 10000; ++i)
+    {
+        c.push_back(i);
+        EXPECT_LE(c.size(), c.capacity());
+    }
+    EXPECT_EQ(iota_vector(0, 10000), contents(c));
+}
+
+TEST(mirrored, wraparound_stays_contiguous)
+{
+    mirrored_circular_buffer<int> c(16);
+    size_t const capacity = c.capacity();
+    int const n = int(capacity);
+    for (int i = 0; i != n; ++i)
+        c.push_back(i);
+
+    // the contents go round the buffer several times without growing it
+    for (int i = n; i != 5 * n + 3; ++i)
+    {
+        c.pop_front();
+        c.push_back(i);
+        ASSERT_EQ(capacity, c.capacity());
+        ASSERT_EQ(c.begin() + n, c.end());
+        ASSERT_EQ(i, c.back());
+        ASSERT_EQ(i - n + 1, c.front());
+    }
+    EXPECT_EQ(iota_vector(4 * n + 3, 5 * n + 3), contents(c));
+
+    ring_spans<int> spans = c.as_spans();
+    EXPECT_EQ(size_t(n), spans.array_one.size());
+    EXPECT_EQ(0u, spans.array_two.size());
+}
+
+TEST(mirrored, push_front_wraps)
+{
+    mirrored_circular_buffer<int> c(16);
+    c.push_back(1);
+    c.push_front(0);
+    c.push_front(-1);
+    EXPECT_EQ(iota_vector(-1, 2), contents(c));
+    EXPECT_EQ(c.begin() + 3, c.end());
+}
+
+TEST(mirrored, matches_deque)
+{
+    mirrored_circular_buffer<int> c;
+    std::deque<int> d;
+    for (int i = 0; i != 100000; ++i)
+    {
+        switch (i * 7 % 5)
+        {
+        case 0:
+        case 1:
+            c.push_back(i);
+            d.push_back(i);
+            break;
+        case 2:
+        case 3:
+            c.push_front(i);
+            d.push_front(i);
+            break;
+        default:
+            if (!d.empty())
+            {
+                c.pop_front();
+                d.pop_front();
+            }
+        }
+    }
+    ASSERT_EQ(d.size(), c.size());
+    EXPECT_TRUE(std::equal(d.begin(), d.end(), c.begin()));
+}
+
+TEST(mirrored, copy)
+{
+    mirrored_circular_buffer<int> c(16);
+    int const n = int(c.capacity());
+    for (int i = 0; i != n; ++i)
+        c.push_back(i);
+    for (int i = n; i != n + 5; ++i)
+    {
+        c.pop_front();
+        c.push_back(i);
+    }
+
+    mirrored_circular_buffer<int> copy(c);
+    EXPECT_EQ(iota_vector(5, n + 5), contents(copy));
+    copy.push_back(-1);
+    c.pop_front();
+    EXPECT_EQ(iota_vector(6, n + 5), contents(c));
+    EXPECT_EQ(-1, copy.back());
+    EXPECT_EQ(5, copy.front());
+}
+
+TEST(mirrored, copy_empty)
+{
+    mirrored_circular_buffer<int> empty;
+    mirrored_circular_buffer<int> copy(empty);
+    EXPECT_TRUE(copy.empty());
+    EXPECT_EQ(0u, copy.capacity());
+
+    mirrored_circular_buffer<int> reserved(16);
+    mirrored_circular_buffer<int> copy2(reserved);
+    EXPECT_TRUE(copy2.empty());
+    copy2.push_back(1);
+    EXPECT_EQ(iota_vector(1, 2), contents(copy2));
+}
+
+TEST(mirrored, assignment)
+{
+    mirrored_circular_buffer<int> a, b;
+    for (int i = 0; i != 100; ++i)
+        a.push_front(99 - i);
+    b.push_back(42);
+
+    b = a;
+    EXPECT_EQ(iota_vector(0, 100), contents(b));
+    a = mirrored_circular_buffer<int>();
+    EXPECT_TRUE(a.empty());
+    EXPECT_EQ(iota_vector(0, 100), contents(b));
+
+    b = b;
+    EXPECT_EQ(iota_vector(0, 100), contents(b));
+}
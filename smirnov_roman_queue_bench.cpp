@@ -0,0 +1,131 @@
+#include "smirnov_roman.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    size_t const OPS = 1 << 21;
+    size_t const QUEUE_SIZE = 4096;
+    size_t const BATCH = 256;
+
+    // the usual queue: notify_one on every push and every pop
+    struct notify_each_queue
+    {
+        explicit notify_each_queue(size_t max_size)
+            : items(ptrdiff_t(max_size)), max_size(max_size), closed(false)
+        {}
+
+        bool push(size_t val)
+        {
+            std::unique_lock<std::mutex> lock(m);
+            not_full.wait(lock, [this] { return items.size() < max_size || closed; });
+            if (closed)
+                return false;
+            items.push_back(val);
+            lock.unlock();
+            not_empty.notify_one();
+            return true;
+        }
+
+        bool pop(size_t& out)
+        {
+            std::unique_lock<std::mutex> lock(m);
+            not_empty.wait(lock, [this] { return !items.empty() || closed; });
+            if (items.empty())
+                return false;
+            out = items.front();
+            items.pop_front();
+            lock.unlock();
+            not_full.notify_one();
+            return true;
+        }
+
+        void close()
+        {
+            {
+                std::lock_guard<std::mutex> lg(m);
+                closed = true;
+            }
+            not_empty.notify_all();
+            not_full.notify_all();
+        }
+
+    private:
+        std::mutex m;
+        std::condition_variable not_empty;
+        std::condition_variable not_full;
+        circular_buffer<size_t> items;
+        size_t max_size;
+        bool closed;
+    };
+
+    struct pop_one
+    {
+        template <typename Queue>
+        static size_t drain(Queue& q)
+        {
+            size_t sum = 0, out;
+            while (q.pop(out))
+                sum += out;
+            return sum;
+        }
+    };
+
+    struct pop_batch
+    {
+        static size_t drain(blocking_queue<size_t>& q)
+        {
+            size_t sum = 0;
+            std::vector<size_t> batch;
+            batch.reserve(BATCH);
+            while (q.pop_up_to(BATCH, std::back_inserter(batch)))
+            {
+                for (size_t v : batch)
+                    sum += v;
+                batch.clear();
+            }
+            return sum;
+        }
+    };
+
+    // producers push OPS values in total, a single consumer (a log writer) drains them
+    template <typename Queue, typename Consumer>
+    double run(size_t producers)
+    {
+        Queue q(QUEUE_SIZE);
+        size_t checksum = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        std::thread consumer([&q, &checksum] { checksum = Consumer::drain(q); });
+        std::vector<std::thread> ts;
+        for (size_t p = 0; p != producers; ++p)
+            ts.emplace_back([&q, p, producers]
+            {
+                for (size_t i = p; i < OPS; i += producers)
+                    q.push(i);
+            });
+        for (std::thread& t : ts)
+            t.join();
+        q.close();
+        consumer.join();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (checksum != OPS * (OPS - 1) / 2)
+            std::fprintf(stderr, "checksum mismatch\n");
+        return OPS / elapsed.count() / 1e6;
+    }
+}
+
+int main()
+{
+    std::printf("%10s %18s %18s %18s\n", "producers", "notify_each Mops", "coalesced Mops", "pop_up_to Mops");
+    for (size_t producers = 1; producers <= 16; producers *= 2)
+        std::printf("%10zu %18.2f %18.2f %18.2f\n", producers,
+                    run<notify_each_queue, pop_one>(producers),
+                    run<blocking_queue<size_t>, pop_one>(producers),
+                    run<blocking_queue<size_t>, pop_batch>(producers));
+}
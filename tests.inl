@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include "fault_injection.h"
+#include "ring_spans.h"
 
 /*template <typename T>
 T const& as_const(T& obj)
@@ -360,6 +361,32 @@ TEST(correctness, erase_end)
     expect_eq(c, {1, 2, 3});
 }
 
+TEST(correctness, insert_middle_wrapped)
+{
+    counted::no_new_instances_guard g;
+
+    container c;
+    c.push_back(0);
+    c.push_front(-1);
+    c.insert(std::next(c.begin(), 1), 100);
+    expect_eq(c, {-1, 100, 0});
+    c.insert(std::next(c.begin(), 2), 200);
+    expect_eq(c, {-1, 100, 200, 0});
+}
+
+TEST(correctness, erase_middle_wrapped)
+{
+    counted::no_new_instances_guard g;
+
+    container c;
+    mass_push_back(c, {1, 2});
+    mass_push_front(c, {0, -1});
+    c.erase(std::next(c.begin(), 1));
+    expect_eq(c, {-1, 1, 2});
+    c.erase(std::next(c.begin(), 1));
+    expect_eq(c, {-1, 2});
+}
+
 TEST(correctness, subscript)
 {
     counted::no_new_instances_guard g;
@@ -478,6 +505,24 @@ TEST(correctness, swap_iterator_validity)
     EXPECT_EQ(c2_end, c2_begin);
 }
 
+TEST(correctness, segmented_algorithms)
+{
+    counted::no_new_instances_guard g;
+
+    container c;
+    mass_push_back(c, {3, 4, 5});
+    mass_push_front(c, {2, 1});
+
+    std::vector<int> vals;
+    segmented::copy(as_const(c), std::back_inserter(vals));
+    EXPECT_EQ((std::vector<int>{1, 2, 3, 4, 5}), vals);
+    EXPECT_EQ(15, segmented::accumulate(as_const(c), 0));
+
+    int visited = 0;
+    segmented::for_each(c, [&visited](counted const& e) { visited += e; });
+    EXPECT_EQ(15, visited);
+}
+
 
 TEST(fault_injection, non_throwing_default_ctor)
 {
@@ -639,3 +684,204 @@ TEST(fault_injection, erase)
         expect_eq(c, {6, 3, 8, 2, 7, 10});
     });
 }
+
+// The stress tests repeat tests from above at a larger scale. Each runs inside an allocation_arena,
+// which keeps the many small allocations cheap and checks that nothing leaked.
+int const STRESS_N = 1 << 14;
+int const STRESS_FAULTY_N = 64;
+
+template <typename C>
+std::vector<int> contents(C& c)
+{
+    fault_injection_disable dg;
+    std::vector<int> res;
+    for (size_t i = 0; i != c.size(); ++i)
+        res.push_back(c[i]);
+    return res;
+}
+
+std::vector<int> iota_vector(int first, int last)
+{
+    fault_injection_disable dg;
+    std::vector<int> res;
+    for (int i = first; i != last; ++i)
+        res.push_back(i);
+    return res;
+}
+
+TEST(stress, size)
+{
+    allocation_arena arena;
+    {
+        counted::no_new_instances_guard g;
+
+        container c;
+        for (int i = 0; i != STRESS_N; ++i)
+        {
+            EXPECT_EQ(size_t(i), c.size());
+            c.push_back(i);
+        }
+        EXPECT_EQ(size_t(STRESS_N), c.size());
+        EXPECT_EQ(iota_vector(0, STRESS_N), contents(c));
+    }
+    EXPECT_EQ(0u, arena.live_allocations());
+}
+
+TEST(stress, pop_back)
+{
+    allocation_arena arena;
+    {
+        counted::no_new_instances_guard g;
+
+        container c;
+        for (int i = 0; i != STRESS_N; ++i)
+            c.push_back(i);
+        for (int i = STRESS_N; i != 0; --i)
+        {
+            EXPECT_EQ(i - 1, c.back());
+            c.pop_back();
+        }
+        EXPECT_TRUE(c.empty());
+    }
+    EXPECT_EQ(0u, arena.live_allocations());
+}
+
+TEST(stress, push_front)
+{
+    allocation_arena arena;
+    {
+        counted::no_new_instances_guard g;
+
+        container c;
+        for (int i = STRESS_N; i != 0; --i)
+            c.push_front(i - 1);
+        EXPECT_EQ(iota_vector(0, STRESS_N), contents(c));
+    }
+    EXPECT_EQ(0u, arena.live_allocations());
+}
+
+TEST(stress, queue)
+{
+    allocation_arena arena;
+    {
+        counted::no_new_instances_guard g;
+
+        int const window = 1000;
+        container c;
+        for (int i = 0; i != window; ++i)
+            c.push_back(i);
+
+        for (int i = window; i != STRESS_N; ++i)
+        {
+            c.push_back(i);
+            c.pop_front();
+        }
+
+        EXPECT_EQ(iota_vector(STRESS_N - window, STRESS_N), contents(c));
+    }
+    EXPECT_EQ(0u, arena.live_allocations());
+}
+
+TEST(stress, bogus_queue)
+{
+    allocation_arena arena;
+    {
+        counted::no_new_instances_guard g;
+
+        int const window = 100;
+        container c;
+        for (int i = 0; i != window; ++i)
+            c.push_back(i);
+
+        for (int i = window; i != STRESS_N; ++i)
+        {
+            c.push_back(i);
+            c.erase(c.begin() + 1);
+        }
+
+        std::vector<int> expected = iota_vector(STRESS_N - window + 1, STRESS_N);
+        expected.insert(expected.begin(), 0);
+        EXPECT_EQ(expected, contents(c));
+    }
+    EXPECT_EQ(0u, arena.live_allocations());
+}
+
+TEST(stress, fault_injection_push_back)
+{
+    faulty_run([]
+    {
+        allocation_arena arena;
+        container c;
+        for (int i = 0; i != STRESS_FAULTY_N; ++i)
+            c.push_back(i);
+
+        try
+        {
+            c.push_back(STRESS_FAULTY_N);
+        }
+        catch (...)
+        {
+            EXPECT_EQ(iota_vector(0, STRESS_FAULTY_N), contents(c));
+            throw;
+        }
+
+        EXPECT_EQ(iota_vector(0, STRESS_FAULTY_N + 1), contents(c));
+    });
+}
+
+TEST(stress, fault_injection_push_front)
+{
+    faulty_run([]
+    {
+        allocation_arena arena;
+        container c;
+        for (int i = 1; i != STRESS_FAULTY_N + 1; ++i)
+            c.push_back(i);
+
+        try
+        {
+            c.push_front(0);
+        }
+        catch (...)
+        {
+            EXPECT_EQ(iota_vector(1, STRESS_FAULTY_N + 1), contents(c));
+            throw;
+        }
+
+        EXPECT_EQ(iota_vector(0, STRESS_FAULTY_N + 1), contents(c));
+    });
+}
+
+TEST(stress, fault_injection_insert)
+{
+    faulty_run([]
+    {
+        allocation_arena arena;
+        container c;
+        for (int i = 0; i != STRESS_FAULTY_N; ++i)
+            c.push_back(i);
+
+        c.insert(c.begin() + STRESS_FAULTY_N / 2, -1);
+
+        std::vector<int> expected = iota_vector(0, STRESS_FAULTY_N);
+        expected.insert(expected.begin() + STRESS_FAULTY_N / 2, -1);
+        EXPECT_EQ(expected, contents(c));
+    });
+}
+
+TEST(stress, fault_injection_erase)
+{
+    faulty_run([]
+    {
+        allocation_arena arena;
+        container c;
+        for (int i = 0; i != STRESS_FAULTY_N; ++i)
+            c.push_back(i);
+
+        c.erase(c.begin() + STRESS_FAULTY_N / 2);
+
+        std::vector<int> expected = iota_vector(0, STRESS_FAULTY_N);
+        expected.erase(expected.begin() + STRESS_FAULTY_N / 2);
+        EXPECT_EQ(expected, contents(c));
+    });
+}
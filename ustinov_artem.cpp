@@ -0,0 +1,144 @@
+#include "ustinov_artem.h"
+#include <counted.h>
+using container = circular_buffer<counted>;
+
+#include "tests.inl"
+
+TEST(bounded, push_back_overwrites_oldest)
+{
+    counted::no_new_instances_guard g;
+
+    container c(3);
+    mass_push_back(c, {1, 2, 3});
+    expect_eq(c, {1, 2, 3});
+    c.push_back(4);
+    expect_eq(c, {2, 3, 4});
+    mass_push_back(c, {5, 6, 7, 8});
+    expect_eq(c, {6, 7, 8});
+    EXPECT_EQ(3u, c.size());
+}
+
+TEST(bounded, push_front_overwrites_newest)
+{
+    counted::no_new_instances_guard g;
+
+    container c(3);
+    mass_push_front(c, {1, 2, 3});
+    expect_eq(c, {3, 2, 1});
+    c.push_front(4);
+    expect_eq(c, {4, 3, 2});
+    mass_push_back(c, {5});
+    expect_eq(c, {3, 2, 5});
+    c.push_front(6);
+    expect_eq(c, {6, 3, 2});
+}
+
+TEST(bounded, pop_and_refill)
+{
+    counted::no_new_instances_guard g;
+
+    container c(2);
+    mass_push_back(c, {1, 2, 3});
+    c.pop_front();
+    expect_eq(c, {3});
+    mass_push_back(c, {4, 5});
+    expect_eq(c, {4, 5});
+    c.pop_back();
+    c.push_front(6);
+    expect_eq(c, {6, 4});
+}
+
+TEST(bounded, no_allocation_after_construction)
+{
+    counted::no_new_instances_guard g;
+
+    size_t const max_size = 4;
+    container c(max_size);
+    c.push_back(0);
+    counted const* first = &c.front();
+
+    for (int i = 1; i != 100; ++i)
+    {
+        if (i % 3 == 0)
+            c.push_front(i);
+        else
+            c.push_back(i);
+
+        EXPECT_LE(c.size(), max_size);
+        for (counted const& e : c)
+        {
+            EXPECT_LE(first, &e);
+            EXPECT_LT(&e, first + max_size + 1);
+        }
+    }
+}
+
+TEST(bounded, insert_full_drops_oldest)
+{
+    counted::no_new_instances_guard g;
+
+    container c(4);
+    mass_push_back(c, {1, 2, 3, 4});
+    auto it = c.insert(c.begin() + 2, 5);
+    EXPECT_EQ(5, *it);
+    expect_eq(c, {2, 5, 3, 4});
+
+    it = c.insert(c.end(), 6);
+    EXPECT_EQ(6, *it);
+    expect_eq(c, {5, 3, 4, 6});
+}
+
+TEST(bounded, insert_full_at_begin_is_dropped)
+{
+    counted::no_new_instances_guard g;
+
+    container c(3);
+    mass_push_back(c, {1, 2, 3});
+    auto it = c.insert(c.begin(), 0);
+    EXPECT_TRUE(it == c.begin());
+    expect_eq(c, {1, 2, 3});
+}
+
+TEST(bounded, insert_not_full)
+{
+    counted::no_new_instances_guard g;
+
+    container c(4);
+    mass_push_back(c, {1, 2, 3});
+    auto it = c.insert(c.begin(), 0);
+    EXPECT_EQ(0, *it);
+    expect_eq(c, {0, 1, 2, 3});
+}
+
+TEST(bounded, copy_is_bounded)
+{
+    counted::no_new_instances_guard g;
+
+    container c(3);
+    mass_push_back(c, {1, 2, 3, 4});
+    container c2 = c;
+    c2.push_back(5);
+    expect_eq(c2, {3, 4, 5});
+
+    container c3;
+    c3 = c2;
+    c3.push_front(6);
+    expect_eq(c3, {6, 3, 4});
+    expect_eq(c, {2, 3, 4});
+}
+
+TEST(bounded, fault_injection_push_back)
+{
+    faulty_run([]
+    {
+        container c(3);
+        {
+            fault_injection_disable dg;
+            mass_push_back(c, {1, 2, 3});
+        }
+        c.push_back(4);
+
+        fault_injection_disable dg;
+        expect_eq(c, {2, 3, 4});
+    });
+}
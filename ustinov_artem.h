@@ -6,14 +6,18 @@
 #define CIRCULAR_BUFFER_CIRCULAR_BUFFER_H
 
 #include <iterator>
+#include <memory>
 #include <cassert>
 
+#include "ring_spans.h"
+
 template<typename T>
 class circular_buffer {
 private:
     size_t _size;
     size_t capacity;
     size_t beg;
+    bool bounded;
     T *data;
 
     template<typename U>
@@ -60,7 +64,7 @@ private:
         }
 
         buffer_iterator &operator+=(ptrdiff_t const &b) {
-            if (p < 0) {
+            if (b < 0) {
                 return *this -= (-b);
             }
             p += (b % cap);
@@ -72,7 +76,7 @@ private:
         }
 
         buffer_iterator &operator-=(ptrdiff_t const &b) {
-            if (p < 0) {
+            if (b < 0) {
                 return *this += (-b);
             }
             p -= (b % cap);
@@ -140,11 +144,20 @@ private:
 
 public:
 
-    circular_buffer() : _size(0), capacity(10), beg(0) {
+    circular_buffer() : _size(0), capacity(10), beg(0), bounded(false) {
         data = static_cast<T *>(malloc(10 * sizeof(T)));
     }
 
-    circular_buffer(circular_buffer const &other) : circular_buffer() {
+    // bounded buffer: holds at most max_size elements and never reallocates,
+    // push_back on a full buffer overwrites the oldest element, push_front the newest one,
+    // insert drops the oldest element (or the inserted one if it would be the oldest)
+    explicit circular_buffer(size_t max_size) : _size(0), capacity(max_size + 1), beg(0), bounded(true) {
+        assert(max_size > 0);
+        data = static_cast<T *>(malloc(capacity * sizeof(T)));
+    }
+
+    circular_buffer(circular_buffer const &other) : _size(0), capacity(other.capacity), beg(0), bounded(other.bounded) {
+        data = static_cast<T *>(malloc(capacity * sizeof(T)));
         try {
             for (const_iterator it = other.begin(); it != other.end(); it++) {
                 push_back(*it);
@@ -225,12 +238,23 @@ public:
     void push_back(T const &value) {
         if (_size + 1 < capacity) {
             new(end().p) T(value);
+        } else if (bounded) {
+            new(data + (beg + _size) % capacity) T(value);
+            data[beg].~T();
+            beg = (beg + 1) % capacity;
+            return;
         } else {
             T *tmp = static_cast<T *>(malloc(sizeof(T) * capacity * 2));
             try {
-                std::copy(begin(), end(), tmp);
+                std::uninitialized_copy(begin(), end(), tmp);
+            } catch (...) {
+                free(tmp);
+                throw;
+            }
+            try {
                 new(tmp + _size) T(value);
             } catch (...) {
+                std::destroy_n(tmp, _size);
                 free(tmp);
                 throw;
             }
@@ -255,15 +279,26 @@ public:
         if (_size + 1 < capacity) {
             new((begin() - 1).p) T(value);
             beg = (capacity + beg - 1) % capacity;
+        } else if (bounded) {
+            new(data + (capacity + beg - 1) % capacity) T(value);
+            data[(beg + _size - 1) % capacity].~T();
+            beg = (capacity + beg - 1) % capacity;
+            return;
         } else {
             T *tmp = static_cast<T *>(malloc(sizeof(T) * capacity * 2));
             try {
-                std::copy(begin(), end(), tmp + 1);
                 new(tmp) T(value);
             } catch (...) {
                 free(tmp);
                 throw;
             }
+            try {
+                std::uninitialized_copy(begin(), end(), tmp + 1);
+            } catch (...) {
+                tmp->~T();
+                free(tmp);
+                throw;
+            }
             size_t tmpsize = _size;
             clear();
             free(data);
@@ -283,21 +318,29 @@ public:
 
 
     iterator insert(const_iterator pos, T const &value) {
-        int sz = pos.pos - begin().pos;
+        ptrdiff_t sz = pos - cbegin();
+        if (bounded && _size + 1 == capacity) {
+            if (sz == 0) {
+                return begin();
+            }
+            // push_back below overwrites the oldest element, which shifts everything left by one
+            sz--;
+        }
         push_back(value);
-        for (iterator it = end() - 1; it > pos; it--) {
+        iterator target = begin() + sz;
+        for (iterator it = end() - 1; it != target; it--) {
             std::swap(*it, *(it - 1));
         }
-        return buffer_iterator((begin() + sz).p, sz + beg, capacity, data);
+        return target;
     }
 
     iterator erase(const_iterator pos) {
-        iterator tmppos = begin() + (pos.pos - beg + capacity) % capacity;
-        for (iterator it = tmppos + 1; it != end(); it++) {
+        ptrdiff_t sz = pos - cbegin();
+        for (iterator it = begin() + sz + 1; it != end(); it++) {
             std::swap(*it, *(it - 1));
         }
         pop_back();
-        return buffer_iterator<T>(data + (beg + pos.pos) % capacity, (pos.pos + capacity) % capacity, capacity, data);
+        return begin() + sz;
     }
 
     T &front() {
@@ -324,6 +367,14 @@ public:
         return _size;
     }
 
+    ring_spans<T> as_spans() {
+        return make_ring_spans(data, capacity, beg, _size);
+    }
+
+    ring_spans<T const> as_spans() const {
+        return make_ring_spans<T const>(data, capacity, beg, _size);
+    }
+
     void clear() {
         while (_size) {
             pop_back();
@@ -335,6 +386,7 @@ public:
         std::swap(a.beg, b.beg);
         std::swap(a._size, b._size);
         std::swap(a.capacity, b.capacity);
+        std::swap(a.bounded, b.bounded);
     }
 };
 
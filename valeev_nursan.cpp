@@ -0,0 +1,179 @@
+#include "valeev_nursan.h"
+#include <counted.h>
+using container = circular_buffer<counted>;
+
+#include "tests.inl"
+
+// a buffer of capacity 6 whose contents {0, 1, 2, 3} start at physical slot 4 and wrap
+container wrapped_buffer()
+{
+    container c;
+    mass_push_back(c, {-3, -2, -1, 0, 1, 2});
+    c.pop_back();
+    c.pop_back();
+    c.pop_back();
+    c.pop_front();
+    c.pop_front();
+    c.pop_front();
+    mass_push_back(c, {0, 1, 2, 3});
+    EXPECT_NE(0u, c.as_spans().array_two.size());
+    return c;
+}
+
+TEST(batch, zero)
+{
+    counted::no_new_instances_guard g;
+
+    container c;
+    std::vector<int> in = {1, 2, 3};
+    std::vector<int> out;
+    c.push_back_n(in.begin(), 0);
+    c.push_front_n(in.begin(), 0);
+    EXPECT_TRUE(c.empty());
+    c.pop_front_n(0, std::back_inserter(out));
+    c.pop_back_n(0, std::back_inserter(out));
+    EXPECT_TRUE(out.empty());
+
+    mass_push_back(c, {1, 2});
+    c.push_back_n(in.begin(), 0);
+    c.pop_front_n(0, std::back_inserter(out));
+    EXPECT_TRUE(out.empty());
+    expect_eq(c, {1, 2});
+}
+
+TEST(batch, push_back_n)
+{
+    counted::no_new_instances_guard g;
+
+    container c;
+    std::vector<int> in = {1, 2, 3, 4, 5};
+    c.push_back_n(in.begin(), 3);
+    c.push_back_n(in.begin() + 3, 2);
+    expect_eq(c, {1, 2, 3, 4, 5});
+}
+
+TEST(batch, push_front_n)
+{
+    counted::no_new_instances_guard g;
+
+    container c;
+    std::vector<int> in = {1, 2, 3, 4, 5};
+    c.push_front_n(in.begin() + 3, 2);
+    c.push_front_n(in.begin(), 3);
+    expect_eq(c, {1, 2, 3, 4, 5});
+    c.push_back(6);
+    expect_eq(c, {1, 2, 3, 4, 5, 6});
+}
+
+TEST(batch, push_back_n_wrapped)
+{
+    counted::no_new_instances_guard g;
+
+    container c = wrapped_buffer();
+    c.pop_front();
+    c.pop_front();
+    std::vector<int> in = {4, 5, 6};
+    c.push_back_n(in.begin(), 3);
+    expect_eq(c, {2, 3, 4, 5, 6});
+}
+
+TEST(batch, push_front_n_wrapped)
+{
+    counted::no_new_instances_guard g;
+
+    container c = wrapped_buffer();
+    c.pop_back();
+    c.pop_back();
+    std::vector<int> in = {-3, -2, -1};
+    c.push_front_n(in.begin(), 3);
+    expect_eq(c, {-3, -2, -1, 0, 1});
+}
+
+TEST(batch, pop_front_n_wrapped)
+{
+    counted::no_new_instances_guard g;
+
+    container c = wrapped_buffer();
+    std::vector<int> out;
+    c.pop_front_n(3, std::back_inserter(out));
+    EXPECT_EQ((std::vector<int>{0, 1, 2}), out);
+    expect_eq(c, {3});
+    c.pop_front_n(1, std::back_inserter(out));
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3}), out);
+    EXPECT_TRUE(c.empty());
+}
+
+TEST(batch, pop_back_n_wrapped)
+{
+    counted::no_new_instances_guard g;
+
+    container c = wrapped_buffer();
+    std::vector<int> out;
+    c.pop_back_n(3, std::back_inserter(out));
+    EXPECT_EQ((std::vector<int>{1, 2, 3}), out);
+    expect_eq(c, {0});
+    c.push_back(7);
+    expect_eq(c, {0, 7});
+}
+
+TEST(batch, push_back_n_grows)
+{
+    counted::no_new_instances_guard g;
+
+    container c = wrapped_buffer();
+    std::vector<int> in = iota_vector(4, 20);
+    c.push_back_n(in.begin(), in.size());
+    EXPECT_EQ(iota_vector(0, 20), contents(c));
+}
+
+TEST(batch, fault_injection_push_back_n)
+{
+    faulty_run([]
+    {
+        container c;
+        {
+            fault_injection_disable dg;
+            c = wrapped_buffer();
+        }
+        std::vector<int> in = iota_vector(4, 8);
+        try
+        {
+            c.push_back_n(in.begin(), in.size());
+        }
+        catch (...)
+        {
+            fault_injection_disable dg;
+            EXPECT_EQ(iota_vector(0, 4), contents(c));
+            throw;
+        }
+        fault_injection_disable dg;
+        EXPECT_EQ(iota_vector(0, 8), contents(c));
+    });
+}
+
+TEST(correctness, copy_ctor_wrapped)
+{
+    counted::no_new_instances_guard g;
+
+    container c = wrapped_buffer();
+    container copy(c);
+    expect_eq(copy, {0, 1, 2, 3});
+    copy.push_front(-1);
+    copy.push_back(4);
+    expect_eq(copy, {-1, 0, 1, 2, 3, 4});
+    expect_eq(c, {0, 1, 2, 3});
+}
+
+TEST(correctness, assignment_operator_wrapped)
+{
+    counted::no_new_instances_guard g;
+
+    container c = wrapped_buffer();
+    container c2;
+    mass_push_back(c2, {5, 6});
+    c2 = c;
+    expect_eq(c2, {0, 1, 2, 3});
+    c2.push_back(4);
+    c2.push_front(-1);
+    expect_eq(c2, {-1, 0, 1, 2, 3, 4});
+}
@@ -1,11 +1,15 @@
 #ifndef CIRCULAR_BUFFER_H
 #define CIRCULAR_BUFFER_H
 
+#include <algorithm>
 #include <cstddef>
 #include <iterator>
+#include <memory>
 #include <type_traits>
 #include <utility>
 
+#include "ring_spans.h"
+
 template <typename T>
 class circular_buffer {
 private:
@@ -29,9 +33,17 @@ private:
         return (_capacity + ind - 1) % _capacity;
     }
 
+    // copies the elements of src (laid out with our _head and _capacity) to dest[0], dest[1], ...;
+    // on an exception the copies already made are destroyed
     void memcp(T* src, T* dest) {
-        for (size_t i = 0, j = _head; i < _size; ++i, ++j) {
-            new (&dest[i]) T(src[getNextPos(j)]);
+        size_t i = 0;
+        try {
+            for (size_t j = _head; i < _size; ++i, ++j) {
+                new (&dest[i]) T(src[getNextPos(j)]);
+            }
+        } catch (...) {
+            std::destroy_n(dest, i);
+            throw;
         }
     }
 
@@ -39,19 +51,51 @@ private:
         if (newsize <= _capacity) {
             return;
         }
-        size_t newcapacity = (_capacity + 3) * 2;
+        size_t newcapacity = std::max((_capacity + 3) * 2, newsize);
         T* newarr = static_cast<T*>(operator new(sizeof(T) * newcapacity));
-        memcp(arr, newarr);
-        while(!empty()) {
-            pop_back();
+        size_t size = _size;
+        try {
+            memcp(arr, newarr);
+        } catch (...) {
+            operator delete(newarr);
+            throw;
         }
         clear();
+        if (_capacity != 0) {
+            operator delete(arr);
+        }
         arr = newarr;
         _capacity = newcapacity;
+        _size = size;
         _head = _capacity - 1;
         _tail = _size;
     }
 
+    // constructs n elements from first at physical positions pos, pos + 1, ... (wrapping), at most two chunks;
+    // on an exception the ones already built are destroyed
+    template <typename ForwardIt>
+    void construct_n(size_t pos, ForwardIt first, size_t n) {
+        size_t chunk = std::min(n, _capacity - pos);
+        std::uninitialized_copy_n(first, chunk, arr + pos);
+        try {
+            std::uninitialized_copy_n(std::next(first, chunk), n - chunk, arr);
+        } catch (...) {
+            std::destroy_n(arr + pos, chunk);
+            throw;
+        }
+    }
+
+    // moves n elements starting at physical position pos to out and destroys them, at most two chunks
+    template <typename OutputIt>
+    OutputIt take_n(size_t pos, size_t n, OutputIt out) {
+        size_t chunk = std::min(n, _capacity - pos);
+        out = std::move(arr + pos, arr + pos + chunk, out);
+        out = std::move(arr, arr + (n - chunk), out);
+        std::destroy_n(arr + pos, chunk);
+        std::destroy_n(arr, n - chunk);
+        return out;
+    }
+
 public:
     using iterator = buffer_iterator<T>;
     using reverse_iterator = std::reverse_iterator<iterator>;
@@ -60,32 +104,41 @@ public:
 
     circular_buffer() {
         _tail = _head = _capacity = _size = 0;
+        arr = nullptr;
     }
 
-    circular_buffer(circular_buffer const& rhs) {
+    circular_buffer(circular_buffer const& rhs) : circular_buffer() {
+        if (rhs._capacity == 0) {
+            return;
+        }
+        T* newarr = static_cast<T*>(operator new(sizeof(T) * rhs._capacity));
+        // memcp reads with our _head and _capacity, then the copy is laid out from 0 as in ensureCapacity
         _capacity = rhs._capacity;
         _size = rhs._size;
         _head = rhs._head;
-        _tail = rhs._tail;
-        arr = static_cast<T*>(operator new(sizeof(T) * _capacity));
-        memcp(rhs.arr, arr);
+        try {
+            memcp(rhs.arr, newarr);
+        } catch (...) {
+            operator delete(newarr);
+            _tail = _head = _capacity = _size = 0;
+            throw;
+        }
+        arr = newarr;
+        _head = _capacity - 1;
+        _tail = _size % _capacity;
     }
 
     circular_buffer& operator=(circular_buffer const& rhs) {
-        if (arr != rhs.arr) {
-            clear();
-            _capacity = rhs._capacity;
-            _size = rhs._size;
-            _head = rhs._head;
-            _tail = rhs._tail;
-            arr = static_cast<T*>(operator new(sizeof(T) * _capacity));
-            memcp(rhs.arr, arr);
-        }
+        circular_buffer copy(rhs);
+        swap(copy);
         return *this;
     }
 
     ~circular_buffer() {
         clear();
+        if (_capacity != 0) {
+            operator delete(arr);
+        }
     }
 
     bool empty() {
@@ -93,8 +146,8 @@ public:
     }
 
     void clear() {
-        if (_capacity != 0) {
-            delete arr;
+        while (!empty()) {
+            pop_back();
         }
     }
 
@@ -102,6 +155,14 @@ public:
         return _size;
     }
 
+    ring_spans<T> as_spans() {
+        return make_ring_spans(arr, _capacity, getNextPos(_head), _size);
+    }
+
+    ring_spans<T const> as_spans() const {
+        return make_ring_spans<T const>(arr, _capacity, getNextPos(_head), _size);
+    }
+
     T operator[](size_t const index) {
         return arr[(_head + index + 1) % _capacity];
     }
@@ -152,6 +213,60 @@ public:
         return arr[getPrevPos(_tail)];
     }
 
+    // Batch versions of push/pop: one capacity check, the elements are copied or moved
+    // in at most two contiguous chunks and destroyed in bulk.
+
+    // appends [first, first + n) in order
+    template <typename ForwardIt>
+    void push_back_n(ForwardIt first, size_t n) {
+        if (n == 0) {
+            return;
+        }
+        ensureCapacity(_size + n);
+        construct_n(_tail, first, n);
+        _tail = (_tail + n) % _capacity;
+        _size += n;
+    }
+
+    // prepends [first, first + n) in order, so *first becomes the front
+    template <typename ForwardIt>
+    void push_front_n(ForwardIt first, size_t n) {
+        if (n == 0) {
+            return;
+        }
+        ensureCapacity(_size + n);
+        size_t start = (_head + 1 + _capacity - n) % _capacity;
+        construct_n(start, first, n);
+        _head = getPrevPos(start);
+        _size += n;
+    }
+
+    // moves the first n elements to out in order and removes them
+    template <typename OutputIt>
+    OutputIt pop_front_n(size_t n, OutputIt out) {
+        if (n == 0) {
+            return out;
+        }
+        size_t start = getNextPos(_head);
+        out = take_n(start, n, out);
+        _head = (_head + n) % _capacity;
+        _size -= n;
+        return out;
+    }
+
+    // moves the last n elements to out in order and removes them
+    template <typename OutputIt>
+    OutputIt pop_back_n(size_t n, OutputIt out) {
+        if (n == 0) {
+            return out;
+        }
+        size_t start = (_tail + _capacity - n) % _capacity;
+        out = take_n(start, n, out);
+        _tail = start;
+        _size -= n;
+        return out;
+    }
+
     void swap(circular_buffer& other) {
         std::swap(_capacity, other._capacity);
         std::swap(_size, other._size);
@@ -320,49 +435,40 @@ public:
 
 template <typename T>
 circular_buffer<T>::buffer_iterator<T> circular_buffer<T>::insert(buffer_iterator<T const> pos, T const& val) {
-    ensureCapacity(_size + 1);
-    buffer_iterator<T> temp(pos.index, arr, _head, _capacity);
-    if (std::abs(pos - begin()) < std::abs(pos - end())) {
+    size_t index = pos.index;
+    if (index < _size - index) {
         push_front(val);
         auto cur = begin();
-        while (cur != temp) {
+        for (size_t i = 0; i != index; ++i, ++cur) {
             std::swap(*cur, *(cur + 1));
-            ++cur;
         }
-        *cur = val;
     } else {
         push_back(val);
-        auto cur = end();
-        while (cur != temp) {
+        auto cur = end() - 1;
+        for (size_t i = _size - 1; i != index; --i, --cur) {
             std::swap(*cur, *(cur - 1));
-            --cur;
         }
-        *cur = val;
     }
-    buffer_iterator<T> ans(pos.index, arr, _head, _capacity);
-    return ans;
+    return begin() + index;
 }
 
 template <typename T>
 circular_buffer<T>::buffer_iterator<T> circular_buffer<T>::erase(buffer_iterator<T const> pos) {
-    buffer_iterator<T> temp(pos.index, arr, _head, _capacity);
-    if (std::abs(pos - begin()) < std::abs(pos - end())) {
-        auto cur = temp;
-        while (cur != begin()) {
+    size_t index = pos.index;
+    if (index < _size - index - 1) {
+        auto cur = begin() + index;
+        for (size_t i = index; i != 0; --i, --cur) {
             std::swap(*cur, *(cur - 1));
-            --cur;
         }
         pop_front();
     } else {
-        auto cur = temp;
-        while (cur != end()) {
+        auto cur = begin() + index;
+        for (size_t i = index; i != _size - 1; ++i, ++cur) {
             std::swap(*cur, *(cur + 1));
-            ++cur;
         }
         pop_back();
     }
-    buffer_iterator<T> ans(pos.index, arr, _head, _capacity);
-    return ans;
+    return begin() + index;
 }
 
 template<typename T>